@@ -0,0 +1,241 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+// Compares IvfFlatIndex and the fp16/int8 storage with the exact fp32 scan of
+// the face gallery on synthetic embeddings: recall of the exact nearest
+// references and search latency.
+//
+// Every synthetic identity is a random unit vector, its images and the
+// queries are that vector with gaussian noise, renormalized. With the default
+// noise two images of one identity have a cosine similarity of about 0.6,
+// close to what the face reidentification model gives.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "embedding_matrix.hpp"
+#include "gallery_index.hpp"
+
+namespace {
+
+const char keys[] =
+    "{ help h     |                      | print this message}"
+    "{ references | 1024,4096,16384,100000 | comma-separated gallery sizes, number of images}"
+    "{ images     | 5                    | images per identity}"
+    "{ dim        | 256                  | embedding size}"
+    "{ noise      | 0.8                  | norm of the noise added to the identity vectors}"
+    "{ queries    | 1024                 | number of faces searched}"
+    "{ batch      | 32                   | faces searched at once, like the faces of one frame}"
+    "{ k          | 32                   | candidates kept per face, recall@k is measured over them}"
+    "{ lists      | 0                    | comma-separated numbers of lists, 0 is the default of the index}"
+    "{ probes     | 0                    | comma-separated numbers of lists to search, 0 is the default of the index}"
+    "{ precision  | fp16,int8            | comma-separated storage precisions scanned exactly next to fp32}"
+    "{ seed       | 7                    | seed of the random embeddings}";
+
+std::vector<std::string> ParseNames(const std::string& text) {
+    std::vector<std::string> names;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty())
+            names.push_back(item);
+    }
+    return names;
+}
+
+std::vector<int> ParseList(const std::string& text) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty())
+            values.push_back(std::stoi(item));
+    }
+    return values;
+}
+
+void Normalize(cv::Mat* rows) {
+    for (int i = 0; i < rows->rows; i++) {
+        cv::Mat row = rows->row(i);
+        cv::normalize(row, row);
+    }
+}
+
+// Rows of noisy copies of the identity vectors, row i belongs to identity owners[i]
+cv::Mat NoisyRows(const cv::Mat& identities, const std::vector<int>& owners, float noise, std::mt19937* rng) {
+    std::normal_distribution<float> gaussian(0.0f, noise / std::sqrt(static_cast<float>(identities.cols)));
+    cv::Mat rows(static_cast<int>(owners.size()), identities.cols, CV_32F);
+    for (int i = 0; i < rows.rows; i++) {
+        const float* identity = identities.ptr<float>(owners[i]);
+        float* row = rows.ptr<float>(i);
+        for (int c = 0; c < rows.cols; c++)
+            row[c] = identity[c] + gaussian(*rng);
+    }
+    Normalize(&rows);
+    return rows;
+}
+
+// Exact top k rows of every query, most similar first
+std::vector<std::vector<GalleryCandidate>> ExactSearch(const EmbeddingMatrix& references, const cv::Mat& queries,
+                                                       size_t k) {
+    cv::Mat similarities;
+    references.Similarities(queries, &similarities);
+    std::vector<std::vector<GalleryCandidate>> candidates(queries.rows);
+    for (int q = 0; q < queries.rows; q++) {
+        const float* row = similarities.ptr<float>(q);
+        std::vector<GalleryCandidate>& found = candidates[q];
+        found.reserve(similarities.cols);
+        for (int r = 0; r < similarities.cols; r++)
+            found.push_back({r, row[r]});
+        const size_t kept = std::min(k, found.size());
+        std::partial_sort(found.begin(), found.begin() + kept, found.end(),
+                          [](const GalleryCandidate& a, const GalleryCandidate& b) {
+                              return a.similarity > b.similarity;
+                          });
+        found.resize(kept);
+    }
+    return candidates;
+}
+
+// recall@1: the exact nearest reference comes first, recall@k: share of the exact top k found
+void Recall(const std::vector<std::vector<GalleryCandidate>>& exact,
+            const std::vector<std::vector<GalleryCandidate>>& found, double* recall_1, double* recall_k) {
+    size_t first = 0, in_top = 0, total = 0;
+    for (size_t q = 0; q < exact.size(); q++) {
+        first += !found[q].empty() && found[q][0].row == exact[q][0].row;
+        for (const auto& expected : exact[q]) {
+            in_top += std::any_of(found[q].begin(), found[q].end(),
+                                  [&expected](const GalleryCandidate& c) { return c.row == expected.row; });
+        }
+        total += exact[q].size();
+    }
+    *recall_1 = static_cast<double>(first) / std::max<size_t>(exact.size(), 1);
+    *recall_k = static_cast<double>(in_top) / std::max<size_t>(total, 1);
+}
+
+// Runs the search over all queries in batches, returns the mean milliseconds per batch
+template <typename Search>
+double TimeBatches(const cv::Mat& queries, int batch, std::vector<std::vector<GalleryCandidate>>* results,
+                   Search search) {
+    results->clear();
+    int batches = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int begin = 0; begin < queries.rows; begin += batch, batches++) {
+        std::vector<std::vector<GalleryCandidate>> found =
+            search(queries.rowRange(begin, std::min(queries.rows, begin + batch)));
+        results->insert(results->end(), found.begin(), found.end());
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / std::max(batches, 1);
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    cv::CommandLineParser parser(argc, argv, keys);
+    parser.about("Face gallery index benchmark");
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    const std::vector<int> sizes = ParseList(parser.get<std::string>("references"));
+    const int images = std::max(parser.get<int>("images"), 1);
+    const int dim = std::max(parser.get<int>("dim"), 1);
+    const float noise = parser.get<float>("noise");
+    const int num_queries = std::max(parser.get<int>("queries"), 1);
+    const int batch = std::max(parser.get<int>("batch"), 1);
+    const size_t k = static_cast<size_t>(std::max(parser.get<int>("k"), 1));
+    const std::vector<int> lists = ParseList(parser.get<std::string>("lists"));
+    const std::vector<int> probes = ParseList(parser.get<std::string>("probes"));
+    std::vector<EmbeddingPrecision> precisions;
+    for (const auto& name : ParseNames(parser.get<std::string>("precision"))) {
+        EmbeddingPrecision precision;
+        if (!ParseEmbeddingPrecision(name, &precision)) {
+            std::cerr << "Unknown precision " << name << std::endl;
+            return 1;
+        }
+        precisions.push_back(precision);
+    }
+    std::mt19937 rng(parser.get<int>("seed"));
+
+    std::cout << std::setw(10) << "references" << std::setw(8) << "lists" << std::setw(8) << "probes"
+              << std::setw(12) << "build ms" << std::setw(12) << "batch ms" << std::setw(11) << "recall@1"
+              << std::setw(11) << "recall@k" << std::endl;
+    for (int size : sizes) {
+        const int num_identities = std::max(size / images, 1);
+        std::normal_distribution<float> gaussian(0.0f, 1.0f);
+        cv::Mat identities(num_identities, dim, CV_32F);
+        for (int i = 0; i < identities.rows; i++) {
+            float* row = identities.ptr<float>(i);
+            for (int c = 0; c < dim; c++)
+                row[c] = gaussian(rng);
+        }
+        Normalize(&identities);
+
+        std::vector<int> owners(size), query_owners(num_queries);
+        for (int i = 0; i < size; i++)
+            owners[i] = i % num_identities;
+        std::uniform_int_distribution<int> any_identity(0, num_identities - 1);
+        for (int& owner : query_owners)
+            owner = any_identity(rng);
+        const cv::Mat references = NoisyRows(identities, owners, noise, &rng);
+        const cv::Mat queries = NoisyRows(identities, query_owners, noise, &rng);
+
+        const EmbeddingMatrix exact_matrix(references, EmbeddingPrecision::FP32);
+        std::vector<std::vector<GalleryCandidate>> exact;
+        const double exact_ms = TimeBatches(queries, batch, &exact, [&](const cv::Mat& rows) {
+            return ExactSearch(exact_matrix, rows, k);
+        });
+        std::cout << std::setw(10) << size << std::setw(8) << "-" << std::setw(8) << "exact" << std::setw(12) << "-"
+                  << std::fixed << std::setprecision(3) << std::setw(12) << exact_ms << std::setw(11) << 1.0
+                  << std::setw(11) << 1.0 << std::endl;
+
+        // exact scans of the quantized storage, listed under its precision
+        for (EmbeddingPrecision precision : precisions) {
+            auto start = std::chrono::steady_clock::now();
+            const EmbeddingMatrix matrix(references, precision);
+            std::chrono::duration<double, std::milli> build_ms = std::chrono::steady_clock::now() - start;
+            std::vector<std::vector<GalleryCandidate>> found;
+            const double scan_ms = TimeBatches(queries, batch, &found, [&](const cv::Mat& rows) {
+                return ExactSearch(matrix, rows, k);
+            });
+            double recall_1, recall_k;
+            Recall(exact, found, &recall_1, &recall_k);
+            std::cout << std::setw(10) << size << std::setw(8) << "-" << std::setw(8)
+                      << EmbeddingPrecisionName(precision) << std::setw(12) << build_ms.count() << std::setw(12)
+                      << scan_ms << std::setw(11) << recall_1 << std::setw(11) << recall_k << std::endl;
+        }
+
+        for (int num_lists : lists) {
+            for (int num_probes : probes) {
+                auto start = std::chrono::steady_clock::now();
+                const IvfFlatIndex index(references, num_lists, num_probes);
+                std::chrono::duration<double, std::milli> build_ms = std::chrono::steady_clock::now() - start;
+
+                std::vector<std::vector<GalleryCandidate>> found;
+                const double index_ms = TimeBatches(queries, batch, &found, [&](const cv::Mat& rows) {
+                    std::vector<std::vector<GalleryCandidate>> candidates;
+                    index.Search(rows, k, &candidates);
+                    return candidates;
+                });
+
+                double recall_1, recall_k;
+                Recall(exact, found, &recall_1, &recall_k);
+                std::cout << std::setw(10) << size << std::setw(8) << index.lists() << std::setw(8) << index.probes()
+                          << std::setw(12) << build_ms.count() << std::setw(12) << index_ms << std::setw(11)
+                          << recall_1 << std::setw(11) << recall_k << std::endl;
+            }
+        }
+    }
+    return 0;
+}
@@ -70,11 +70,27 @@ struct ActionDetectorConfig : public CnnConfig {
 class ActionDetection : public BaseCnnDetection {
 public:
     explicit ActionDetection(const ActionDetectorConfig& config);
+    /**
+    * @brief Creates a detector that shares the loaded network of other,
+    * but has its own pool of infer requests
+    */
+    ActionDetection(const ActionDetection& other);
+
+    /**
+    * @brief Starts inference of a frame on a free infer request of the pool
+    *
+    * @param frame Input image
+    * @param frame_id Id returned together with the results of the frame
+    */
+    void SubmitFrame(const cv::Mat &frame, size_t frame_id);
 
-    DetectedActions results;
-    void submitRequest() override;
-    void enqueue(const cv::Mat &frame);
-    void fetchResults();
+    /**
+    * @brief Waits for the oldest frame in flight and fetches its results
+    *
+    * @param detections Detections of the frame
+    * @return Id of the frame
+    */
+    size_t FetchOldest(DetectedActions* detections);
 
 private:
     ActionDetectorConfig config_;
@@ -82,10 +98,18 @@ private:
     std::string input_name_;
     InferenceEngine::BlobMap outputs_;
 
-    int enqueued_frames_ = 0;
-    float width_ = 0;
-    float height_ = 0;
-    bool results_fetched_ = false;
+    InferRequestPool pool_;
+
+    /**
+    * @brief Translates the outputs of a finished infer request
+    *
+    * @param request Infer request
+    * @param frame_size Size of input image (WxH)
+    * @param detections Detected objects
+    */
+    void ParseDetections(InferenceEngine::InferRequest& request, const cv::Size& frame_size,
+                         DetectedActions* detections) const;
+
     /**
     * @brief BBox in normalized form (each coordinate is in range [0;1]).
     */
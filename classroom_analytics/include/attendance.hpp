@@ -0,0 +1,176 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+* @brief Students of the gallery under dense ids, immutable once built
+*
+* The id of a student is its position in the gallery, the same id the face
+* gallery assigns to the tracked faces. Labels are looked up by hash. The
+* gallery keeps the ids of students removed from it, so the roster keeps
+* them as well, marked as no longer enrolled.
+*/
+class Roster {
+public:
+    /**
+   * @brief Constructor
+   *
+   * @param labels Gallery labels, indexed by id
+   */
+    explicit Roster(const std::vector<std::string>& labels);
+
+    /**
+   * @brief Constructor
+   *
+   * @param labels Gallery labels, indexed by id
+   * @param enrolled Whether every student is still in the gallery, indexed by id
+   */
+    Roster(const std::vector<std::string>& labels, const std::vector<bool>& enrolled);
+
+    /**
+   * @brief Returns number of ids, including the students that are no longer enrolled
+   */
+    size_t size() const { return labels_.size(); }
+
+    /**
+   * @brief Returns the gallery label of a student
+   */
+    const std::string& Label(int id) const { return labels_[id]; }
+
+    /**
+   * @brief Indicates whether the student is in the current gallery
+   */
+    bool Enrolled(int id) const { return enrolled_[id]; }
+
+    /**
+   * @brief Returns the id of a label, or -1 if it is not on the roster
+   */
+    int Find(const std::string& label) const;
+
+private:
+    std::vector<std::string> labels_;
+    std::vector<bool> enrolled_;
+    std::unordered_map<std::string, int> ids_;
+};
+
+/**
+* @brief Roster snapshot shared by all classrooms
+*
+* Readers take the current snapshot without locking and keep using it for as
+* long as they need. Snapshots are only built from a loaded face gallery,
+* never from the gallery file, so every student on the roster can be
+* recognized. A reload of the gallery publishes a new snapshot instead of
+* changing the old one.
+*/
+class SharedRoster {
+public:
+    /**
+   * @brief Constructor
+   *
+   * @param initial Roster matching the ids of the loaded face gallery
+   */
+    explicit SharedRoster(std::shared_ptr<const Roster> initial);
+
+    /**
+   * @brief Returns the current snapshot
+   */
+    std::shared_ptr<const Roster> Current() const;
+
+    /**
+   * @brief Replaces the current snapshot
+   */
+    void Publish(std::shared_ptr<const Roster> roster);
+
+private:
+    std::shared_ptr<const Roster> roster_;
+};
+
+/**
+* @brief Attendance of one student in a session
+*/
+struct AttendanceRecord {
+    /** @brief Id of the student on the roster */
+    int id;
+    /** @brief Student was seen at least once */
+    bool present;
+    /** @brief Time the student was seen first, only valid if present */
+    std::chrono::system_clock::time_point first_seen;
+    /** @brief Time the student was seen last, only valid if present */
+    std::chrono::system_clock::time_point last_seen;
+};
+
+/**
+* @brief Attendance of the whole roster in a finished session
+*/
+struct AttendanceReport {
+    /** @brief Roster of the session */
+    std::shared_ptr<const Roster> roster;
+    /** @brief Subject of the session */
+    std::string subject;
+    /** @brief Time the session started */
+    std::chrono::system_clock::time_point start;
+    /** @brief Time the session ended */
+    std::chrono::system_clock::time_point end;
+    /** @brief One record per enrolled student, in id order */
+    std::vector<AttendanceRecord> records;
+};
+
+/**
+* @brief Tracks which students of a classroom attend its sessions
+*
+* A session lasts as long as the session key, e.g. the timetable slot, stays
+* the same. Within a session a presence bitmap and the first/last seen times
+* are kept per student id, so observing the identified faces of a frame costs
+* no string work. Every session yields exactly one report, when the next one
+* starts or when the tracker is finished. A session keeps the roster it
+* started with.
+*/
+class AttendanceTracker {
+public:
+    AttendanceTracker();
+
+    /**
+   * @brief Moves to the given session, ending the current one if the key differs
+   *
+   * @param session Key of the session
+   * @param subject Subject reported for the session
+   * @param roster Students expected in the session, only used if a new session starts
+   * @param now Current time
+   * @param report Receives the report of the ended session
+   * @return true if a session ended and the report has been filled
+   */
+    bool SwitchSession(const std::string& session, const std::string& subject,
+                       const std::shared_ptr<const Roster>& roster,
+                       std::chrono::system_clock::time_point now, AttendanceReport* report);
+
+    /**
+   * @brief Ends the current session
+   *
+   * @return true if a session was running and the report has been filled
+   */
+    bool EndSession(std::chrono::system_clock::time_point now, AttendanceReport* report);
+
+    /**
+   * @brief Marks students as seen in the current session, unknown ids are ignored
+   */
+    void Observe(const std::vector<int>& ids, std::chrono::system_clock::time_point now);
+
+private:
+    std::shared_ptr<const Roster> roster_;
+    bool active_;
+    std::string session_;
+    std::string subject_;
+    std::chrono::system_clock::time_point start_;
+    std::vector<uint64_t> present_;
+    std::vector<std::chrono::system_clock::time_point> first_seen_;
+    std::vector<std::chrono::system_clock::time_point> last_seen_;
+};
@@ -9,7 +9,17 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <mutex>
 #include <gflags/gflags.h>
+#include "attendance.hpp"
+#include "influx_writer.hpp"
+#include "pipeline.hpp"
+#include "rollup.hpp"
+#include "scheduler.hpp"
+#include "timetable.hpp"
 
 #ifdef _WIN32
 #include <os/windows/w_dirent.h>
@@ -45,17 +55,45 @@ struct ClassroomInfo
     map<Sentiment, int> sent;
 };
 
+// StampedFrame is a decoded frame together with the faces found on it. It is never
+// modified once published, so the pipeline stages and the sentiment worker can
+// share it without copying.
+struct StampedFrame
+{
+    size_t index;
+    chrono::steady_clock::time_point timestamp;
+    Mat image;
+    // faces and their confidences as reported by the face detector for this frame
+    vector<Rect> faces;
+    vector<float> confidences;
+};
+typedef shared_ptr<const StampedFrame> StampedFramePtr;
+
+// ClassroomState holds the sentiment/attention statistics of one classroom stream.
+struct ClassroomState
+{
+    // frames hands the newest decoded frame to the sentiment worker
+    LatestRing<StampedFramePtr> frames;
+    // currentInfo contains the latest ClassroomInfo tracked for the classroom.
+    ClassroomInfo currentInfo;
+    mutex m2;
+    // cadences of the networks run by the sentiment worker
+    Cadence headPoseCadence;
+    Cadence emotionsCadence;
+
+    ClassroomState() : frames(4) {}
+};
+
 extern "C"
 {
-	// nextImageAvailable returns the next image from the queue in a thread-safe way
-	Mat nextImageAvailable();
-	// addImage adds an image to the queue in a thread-safe way
-	void addImage(Mat img);
-	// getCurrentInfo returns the most-recent ClassroomInfo for the application.
-	ClassroomInfo getCurrentInfo();
-	// updateInfo uppdates the current ClassroomInfo for the application to the highest values
+	// publishFrame hands a frame and its detected faces to the sentiment worker of the classroom
+	void publishFrame(ClassroomState& state, size_t index, const Mat& img,
+			const vector<Rect>& faces, const vector<float>& confidences);
+	// getCurrentInfo returns the most-recent ClassroomInfo for the classroom.
+	ClassroomInfo getCurrentInfo(ClassroomState& state);
+	// updateInfo uppdates the current ClassroomInfo for the classroom to the highest values
 	// during the current time period.
-	void updateInfo(ClassroomInfo info);
+	void updateInfo(ClassroomState& state, ClassroomInfo info);
 	// resetInfo resets the current ClassroomInfo for the application.
 	void resetInfo();
 	// getCurrentPerf returns a display string with the most current performance stats for the Inference Engine.
@@ -69,7 +107,7 @@ extern "C"
 	//Classroom Participation Index	
 	double ParticipationIndex(double StandingStudents, double total_students);
 	// Function called by worker thread to process the next available video frame.
-	void frameRunner();
+	void frameRunner(ClassroomState& state, HeadPoseDetection& headPoseDetector, EmotionsDetection& emotionsDetector);
 	// signal handler for the main thread
 	void handle_sigterm(int signum);
 	void timechecker();
@@ -253,7 +291,7 @@ DEFINE_int32(last_frame, -1, last_frame_message);
 const char* keys =
     "{ help  h      | | Print help message. }"
     "{ device d     | 0 | camera device number. }"
-    "{ input i      | | Path to input camera Stream or video file.}"
+    "{ input i      | | Path to input camera Stream or video file. A comma-separated list serves several classrooms from one process.}"
     "{ config c     | | Path to .xml file of model containing network configuration. }"
     "{ faceconf fc  | 0.5 | Confidence factor for face detection required. }"
     "{ moodconf mc  | 0.5 | Confidence factor for emotion detection required. }"
@@ -263,24 +301,35 @@ const char* keys =
     "{ landmarksregressionconfig lrc    | | Path to a .xml file of landmarks-regression-retail containing network configuration. }"
     "{ facereidentificationconfig frc    | | Path to a .xml file of face-reidentification-retail containing network configuration. }"
     "{ facegallerypath fgp     | | Path to a faces gallery.}"
+    "{ fg_cache        | | path to the cache of the face gallery embeddings, by default the gallery path followed by .cache}"
+    "{ fg_index        | auto | index of the face gallery: flat scans every image, ivf searches the closest clusters and ranks their images exactly, auto uses ivf from 8192 images on}"
+    "{ fg_precision    | fp32 | storage of the face gallery embeddings scanned without index: fp32, fp16 or int8, checked against fp32 at load}"
     "{ device d_act |CPU|  Optional. Specify the target device for Person/Action Detection Retail (CPU, GPU, HDDL).}"
     "{ device d_fd |CPU|   Optional. Specify the target device for Face Detection Retail (CPU, GPU, HDDL).}"
     "{ device d_lm |CPU|   Optional. Specify the target device for Landmarks Regression Retail (CPU, GPU,HDDL).}"
     "{ device d_reid |CPU| Optional. Specify the target device for Face Reidentification Retail (CPU, GPU, HDDL).}"
     "{ device d_hp |CPU| Optional. Specify the target device for Headpose Retail (CPU, GPU).}"
     "{ device d_em |CPU| Optional. Specify the target device for Emotions Retail (CPU, GPU).}"
-    "{ backend b    | 0 | Choose one of computation backends: "
-                        "0: automatically (by default), "
-                        "1: Halide language (http://halide-lang.org/), "
-                        "2: Intel's Deep Learning Inference Engine (https://software.intel.com/openvino-toolkit), "
-                        "3: OpenCV implementation }"
-    "{ target t     | 0 | Choose one of target computation devices: "
-                        "0: CPU target (by default), "
-                        "1: OpenCL, "
-                        "2: OpenCL fp16 (half-float precision), "
-                        "3: VPU }"
-    "{ section cs  |DEFAULT| specify the class section}"
-    "{ influxip db_ip  |172.21.0.6| specify the Ip Address of the InfluxDB container}"
-    "{ noshow no-show  | 0 | specify no-show = 1 if don't want to see the processed Video}"; 
+    "{ section cs  |DEFAULT| specify the class section, or a comma-separated list with one section per input}"
+    "{ influxip db_ip  |172.21.0.6| specify the Ip Address of the InfluxDB container, optionally followed by :port}"
+    "{ db_batch        | 500 | number of points the database writer sends in one request}"
+    "{ db_flush_ms     | 1000 | longest time in ms a point waits before the database writer sends it}"
+    "{ db_spool        | metrics_spool | directory that keeps the points while the database is unavailable, empty to keep them in memory}"
+    "{ db_replay_rate  | 1000 | points per second replayed from the spool once the database is back}"
+    "{ timetable tt    | /opt/intel/openvino/inference_engine/samples/classroom_analytics/timetable.txt | path to the timetable, lines Subject-H or Subject-HH:MM-HH:MM[-Mon,Tue,...], reloaded when it changes}"
+    "{ rollup          | 1,10,60 | comma-separated windows in seconds, min/max/mean/last of every window are written instead of every frame, 0 writes every frame}"
+    "{ noshow no-show  | 0 | specify no-show = 1 if don't want to see the processed Video, runs headless unless a video is written}"
+    "{ queuesize qs  | 2 | number of frames buffered between two pipeline stages}"
+    "{ nireq nr  | 2 | number of infer requests every detection and face network keeps in flight per classroom}"
+    "{ act_every  | 1 | run person/action detection on every n-th frame, the tracker carries the persons in between}"
+    "{ fd_every   | 1 | run face detection on every n-th frame, the tracker carries the faces in between}"
+    "{ reid_every | 1 | run landmarks and face reidentification at most every n-th frame}"
+    "{ reid_track_weight | 10 | faces of full quality a face track averages its reid embeddings over before older faces fade out, 0 matches every face on its own}"
+    "{ reid_verify_every | 30 | frames a face track keeps an identity reid confirmed 3 times in a row before reid checks it again, 0 runs reid on every face}"
+    "{ hp_every   | 1 | run head pose estimation at most every n-th frame with fresh face detections}"
+    "{ em_every   | 1 | run emotions recognition at most every n-th frame with fresh face detections}"
+    "{ adaptive_cadence ac | 0 | specify 1 to stretch the run intervals up to 4x while the number of detections does not change}"
+    "{ live | 0 | specify live = 1 to always process the newest camera frame and drop the stale ones, implied for cam}"
+    "{ latency | 1000 | end-to-end latency target in ms, live frames that take longer are counted as late}"; 
 #endif
 
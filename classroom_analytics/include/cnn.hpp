@@ -9,6 +9,11 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <thread>
 
 #include <samples/ocv_common.hpp>
 
@@ -30,6 +35,10 @@ struct CnnConfig {
     int max_batch_size{1};
     /** @brief Enabled/disabled status */
     bool enabled{true};
+    /** @brief Number of infer requests that may be in flight at once */
+    int num_requests{1};
+    /** @brief Parallel inference streams of the device, 0 runs num_requests streams */
+    int num_streams{0};
 
     /** @brief Plugin to use for inference */
     InferenceEngine::Core plugin;
@@ -38,6 +47,91 @@ struct CnnConfig {
    std::string device;
 };
 
+/**
+* @brief Returns the LoadNetwork() config that lets the device run num_streams requests in parallel
+*
+* CPU streams are capped at the number of hardware threads, more would only oversubscribe the cores.
+*/
+std::map<std::string, std::string> ThroughputConfig(const std::string& device, int num_streams);
+
+/**
+* @brief Returns the number of streams a network of config is loaded with
+*/
+inline int NumStreams(const CnnConfig& config) {
+    return config.num_streams > 0 ? config.num_streams : config.num_requests;
+}
+
+/**
+* @brief Infer request of a pool together with the frame it is running on
+*/
+struct InFlightRequest {
+    /** @brief IE InferRequest */
+    InferenceEngine::InferRequest::Ptr request;
+    /** @brief Id of the frame given by the caller */
+    size_t frame_id;
+    /** @brief Size of the frame */
+    cv::Size frame_size;
+};
+
+/**
+* @brief Ring of infer requests that keeps several frames in flight
+*
+* Frames are started on the free requests in turn, so the oldest request in
+* flight always holds the oldest frame and results come back in submission order.
+*/
+class InferRequestPool {
+public:
+    InferRequestPool() : head_(0), in_flight_(0) {}
+
+    /**
+   * @brief Creates size infer requests of the network
+   */
+    void Create(InferenceEngine::ExecutableNetwork& net, size_t size);
+
+    /**
+    * @brief Indicates whether the requests have been created
+    */
+    bool Created() const { return !requests_.empty(); }
+
+    /**
+    * @brief Indicates whether every request is in flight
+    */
+    bool Full() const { return in_flight_ == requests_.size(); }
+
+    /**
+    * @brief Returns number of requests in flight
+    */
+    size_t InFlight() const { return in_flight_; }
+
+    /**
+    * @brief Returns the free request the next frame has to be written into
+    */
+    const InferenceEngine::InferRequest::Ptr& Free() const;
+
+    /**
+   * @brief Starts the request returned by Free()
+   *
+   * @param frame_id Id of the frame
+   * @param frame_size Size of the frame
+   */
+    void Start(size_t frame_id, const cv::Size& frame_size);
+
+    /**
+    * @brief Waits for the oldest request in flight
+    */
+    const InFlightRequest& WaitOldest();
+
+    /**
+    * @brief Frees the oldest request once its outputs have been read
+    */
+    void Release();
+
+private:
+    std::vector<InFlightRequest> requests_;
+    size_t head_;
+    size_t in_flight_;
+};
+
 /**
 * @brief Base class of network
 */
@@ -71,6 +165,18 @@ public:
     bool Enabled() const;
 
 protected:
+    /**
+   * @brief Takes an idle infer request
+   *
+   * @param wait Wait for a request if none is idle, otherwise return nullptr
+   */
+    InferenceEngine::InferRequest::Ptr AcquireRequest(bool wait) const;
+
+    /**
+   * @brief Returns a request taken by AcquireRequest()
+   */
+    void ReleaseRequest(const InferenceEngine::InferRequest::Ptr& request) const;
+
     /**
    * @brief Run network
    *
@@ -83,6 +189,9 @@ protected:
     /**
    * @brief Run network in batch mode
    *
+   * Batches of max_batch_size images run in parallel on the idle infer requests,
+   * results_fetcher is called for them in order.
+   *
    * @param frames Vector of input images
    * @param results_fetcher Callback to fetch inference results
    */
@@ -97,8 +206,14 @@ protected:
     InferenceEngine::OutputsDataMap outInfo_;
     /** @brief IE network */
     InferenceEngine::ExecutableNetwork executable_network_;
-    /** @brief IE InferRequest */
-    mutable InferenceEngine::InferRequest infer_request_;
+    /** @brief IE InferRequests, performance counts are reported for the first one */
+    std::vector<InferenceEngine::InferRequest::Ptr> infer_requests_;
+    /** @brief Requests that are not used by any InferBatch() call */
+    mutable std::vector<InferenceEngine::InferRequest::Ptr> idle_requests_;
+    /** @brief Guards idle_requests_, InferBatch() may be called from several threads */
+    mutable std::mutex idle_mutex_;
+    /** @brief Signals that a request became idle */
+    mutable std::condition_variable idle_cv_;
     /** @brief Name of the input blob input blob */
     std::string input_blob_name_;
     /** @brief Names of output blobs */
@@ -109,10 +224,44 @@ class VectorCNN : public CnnDLSDKBase {
 public:
     explicit VectorCNN(const CnnConfig& config);
 
+    /**
+   * @brief Destructor, finishes the queued ComputeAsync() calls and stops the workers
+   */
+    ~VectorCNN();
+
     void Compute(const cv::Mat& image,
                  cv::Mat* vector, cv::Size outp_shape = cv::Size()) const;
     void Compute(const std::vector<cv::Mat>& images,
                  std::vector<cv::Mat>* vectors, cv::Size outp_shape = cv::Size()) const;
+
+    /**
+   * @brief Computes vectors of images on a background thread
+   *
+   * The calls are queued to long-lived workers, one per infer request, which
+   * are started by the first call.
+   *
+   * @param images Input images
+   * @param outp_shape Shape of every output vector
+   * @param prepare Runs on the worker before the images are computed, e.g. aligns them
+   * @return Future that becomes ready with one vector per image
+   */
+    std::future<std::vector<cv::Mat>> ComputeAsync(const std::vector<cv::Mat>& images,
+                                                   cv::Size outp_shape = cv::Size(),
+                                                   std::function<void(std::vector<cv::Mat>*)> prepare = nullptr) const;
+
+private:
+    void AsyncLoop() const;
+
+    /** @brief Guards the queue and the workers of ComputeAsync() */
+    mutable std::mutex async_mutex_;
+    /** @brief Signals a queued call or the stop */
+    mutable std::condition_variable async_cv_;
+    /** @brief Calls waiting for a worker */
+    mutable std::deque<std::packaged_task<std::vector<cv::Mat>()>> async_tasks_;
+    /** @brief Worker threads */
+    mutable std::vector<std::thread> async_workers_;
+    /** @brief Set by the destructor */
+    bool async_stopped_ = false;
 };
 
 class BaseCnnDetection {
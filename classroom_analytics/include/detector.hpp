@@ -11,6 +11,9 @@
 #include "cnn.hpp"
 #include <gflags/gflags.h>
 #include <functional>
+#include <array>
+#include <mutex>
+#include <condition_variable>
 #include <iostream>
 #include <fstream>
 #include <random>
@@ -57,11 +60,27 @@ struct DetectorConfig : public CnnConfig {
 class FaceDetection : public BaseCnnDetection {
 public:
     explicit FaceDetection(const DetectorConfig& config);
-
-    DetectedObjects results;
-    void submitRequest() override;
-    void enqueue(const cv::Mat &frame);
-    void fetchResults();
+    /**
+    * @brief Creates a detector that shares the loaded network of other,
+    * but has its own pool of infer requests
+    */
+    FaceDetection(const FaceDetection& other);
+
+    /**
+    * @brief Starts inference of a frame on a free infer request of the pool
+    *
+    * @param frame Input image
+    * @param frame_id Id returned together with the results of the frame
+    */
+    void SubmitFrame(const cv::Mat &frame, size_t frame_id);
+
+    /**
+    * @brief Waits for the oldest frame in flight and fetches its results
+    *
+    * @param detections Detections of the frame
+    * @return Id of the frame
+    */
+    size_t FetchOldest(DetectedObjects* detections);
 
 private:
     DetectorConfig config_;
@@ -70,10 +89,10 @@ private:
     std::string output_name_;
     int max_detections_count_ = 0;
     int object_size_ = 0;
-    int enqueued_frames_ = 0;
-    float width_ = 0;
-    float height_ = 0;
-    bool results_fetched_ = false;
+    InferRequestPool pool_;
+
+    void ParseDetections(InferenceEngine::InferRequest& request, const cv::Size& frame_size,
+                         DetectedObjects* detections) const;
 };
 
 } // namespce detection
@@ -83,16 +102,23 @@ private:
 struct BaseDetection {
     InferenceEngine::ExecutableNetwork net;
     InferenceEngine::Core * plugin;
-    InferenceEngine::InferRequest::Ptr request;
     std::string topoName;
     std::string pathToModel;
     std::string deviceForInference;
     const size_t maxBatch;
     bool isBatchDynamic;
     const bool isAsync;
-    mutable bool enablingChecked;
-    mutable bool _enabled;
+    /** @brief Set by the constructor, so the detectors shared by the classrooms only read it */
+    const bool _enabled;
     const bool doRawOutputMessages;
+    /** @brief Infer requests, every Compute() call holds one, so classrooms run in parallel */
+    std::vector<InferenceEngine::InferRequest::Ptr> requests;
+    /** @brief Requests that are not held by any Compute() call */
+    std::vector<InferenceEngine::InferRequest::Ptr> idleRequests;
+    /** @brief Guards idleRequests */
+    std::mutex idleMutex;
+    /** @brief Signals that a request became idle */
+    std::condition_variable idleCv;
 
    BaseDetection(std::string topoName,
                   const std::string &pathToModel,
@@ -104,8 +130,26 @@ struct BaseDetection {
 
     InferenceEngine::ExecutableNetwork* operator ->();
     virtual InferenceEngine::CNNNetwork read() = 0;
-    virtual void submitRequest();
-    virtual void wait();
+
+    /**
+    * @brief Creates count infer requests of the loaded network
+    */
+    void createRequests(int count);
+
+    /**
+    * @brief Takes an idle infer request, waiting for one if all of them are held
+    */
+    InferenceEngine::InferRequest::Ptr acquireRequest();
+
+    /**
+    * @brief Returns a request taken by acquireRequest()
+    */
+    void releaseRequest(const InferenceEngine::InferRequest::Ptr& request);
+
+    /**
+    * @brief Runs the request on its first numFaces inputs and waits for the results
+    */
+    void submitRequest(InferenceEngine::InferRequest& request, size_t numFaces);
     bool enabled() const;
 };
 
@@ -120,7 +164,6 @@ struct HeadPoseDetection : BaseDetection {
     std::string outputAngleR;
     std::string outputAngleP;
     std::string outputAngleY;
-    size_t enquedFaces;
     cv::Mat cameraMatrix;
 
     HeadPoseDetection(const std::string &pathToModel,
@@ -129,16 +172,25 @@ struct HeadPoseDetection : BaseDetection {
                       bool doRawOutputMessages);
 
     InferenceEngine::CNNNetwork read() override;
-    void submitRequest() override;
 
-    void enqueue(const cv::Mat &face);
-    Results operator[] (int idx) const;
+    void enqueue(InferenceEngine::InferRequest &request, const cv::Mat &face, size_t idx);
+    Results fetch(InferenceEngine::InferRequest &request, int idx) const;
+
+    /**
+    * @brief Estimates head poses of all faces, in batches of at most maxBatch faces
+    *
+    * @param faces Face crops
+    * @param results Head pose of every face, in the order of faces
+    */
+    void Compute(const std::vector<cv::Mat> &faces, std::vector<Results> *results);
 };
 
 struct EmotionsDetection : BaseDetection {
+    /** @brief Probabilities in the order of emotionsVec */
+    using Results = std::array<float, 5>;
+
     std::string input;
     std::string outputEmotions;
-    size_t enquedFaces;
 
     EmotionsDetection(const std::string &pathToModel,
                       const std::string &deviceForInference,
@@ -146,10 +198,17 @@ struct EmotionsDetection : BaseDetection {
                       bool doRawOutputMessages);
 
     InferenceEngine::CNNNetwork read() override;
-    void submitRequest() override;
 
-    void enqueue(const cv::Mat &face);
-    std::map<std::string, float> operator[] (int idx) const;
+    void enqueue(InferenceEngine::InferRequest &request, const cv::Mat &face, size_t idx);
+    Results fetch(InferenceEngine::InferRequest &request, int idx) const;
+
+    /**
+    * @brief Recognizes emotions of all faces, in batches of at most maxBatch faces
+    *
+    * @param faces Face crops
+    * @param results Emotion probabilities of every face, in the order of faces
+    */
+    void Compute(const std::vector<cv::Mat> &faces, std::vector<Results> *results);
 
     const std::vector<std::string> emotionsVec = {"neutral", "happy", "sad", "surprise", "anger"};
 };
@@ -159,6 +218,10 @@ struct Load {
 
     explicit Load(BaseDetection& detector);
 
-    void into(InferenceEngine::Core & plg, std::string device, bool enable_dynamic_batch = false) const;
+    /**
+    * @brief Loads the network to the device with num_requests parallel infer requests
+    */
+    void into(InferenceEngine::Core & plg, std::string device, bool enable_dynamic_batch = false,
+              int num_requests = 1) const;
 };
 
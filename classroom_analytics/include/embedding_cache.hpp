@@ -0,0 +1,111 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+/**
+* @brief Returns the 64-bit FNV-1a hash of a buffer
+*
+* @param data Buffer
+* @param size Size of the buffer in bytes
+* @param seed Hash of the preceding data, to hash several buffers as one
+*/
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ULL);
+
+/**
+* @brief Returns the hash of the contents of the given files and of the given strings
+*
+* Used as model identity: the paths of the network files, their contents and
+* the devices they run on. A missing file only contributes its path.
+*/
+uint64_t HashFiles(const std::vector<std::string>& paths, const std::vector<std::string>& strings);
+
+/**
+* @brief Embeddings of gallery images kept on disk between runs
+*
+* Entries are keyed by the hash of the image file contents, the whole cache
+* by the identity of the models that computed the embeddings, so changing an
+* image or a model only invalidates what it affects. The file is a fixed size
+* header followed by entries sorted by key, each the key and the floats of
+* the embedding. It is mapped into memory and searched in place, a lookup is
+* a binary search.
+*
+* Save() rewrites the file with the entries that have been found or added
+* since the last BeginBuild(), so images removed from the gallery drop out.
+* The new file is written next to the old one and renamed over it.
+*/
+class EmbeddingCache {
+public:
+    /**
+   * @brief Constructor, maps the cache file if it exists and matches the model
+   *
+   * @param path Path to the cache file
+   * @param model Identity of the models, see HashFiles()
+   */
+    EmbeddingCache(const std::string& path, uint64_t model);
+
+    ~EmbeddingCache();
+
+    EmbeddingCache(const EmbeddingCache&) = delete;
+    EmbeddingCache& operator=(const EmbeddingCache&) = delete;
+
+    /**
+   * @brief Returns number of entries of the mapped file
+   */
+    size_t size() const { return count_; }
+
+    /**
+   * @brief Starts a gallery build, entries the build does not find or add are dropped by the next Save()
+   */
+    void BeginBuild();
+
+    /**
+   * @brief Looks up the embedding of an image
+   *
+   * @param key Hash of the image file contents
+   * @param embedding Receives a copy of the embedding, a column of floats
+   * @return false if the image has no embedding in the cache
+   */
+    bool Find(uint64_t key, cv::Mat* embedding);
+
+    /**
+   * @brief Adds the embedding of an image, written by the next Save()
+   */
+    void Add(uint64_t key, const cv::Mat& embedding);
+
+    /**
+   * @brief Indicates whether the entries used by the build differ from the mapped file
+   */
+    bool Changed() const;
+
+    /**
+   * @brief Writes the entries that have been found or added since BeginBuild()
+   *
+   * @return false if the file could not be written, the old one stays in place
+   */
+    bool Save();
+
+private:
+    void Map();
+    void Unmap();
+    const char* Entry(size_t index) const;
+
+    const std::string path_;
+    const uint64_t model_;
+    const char* data_;
+    size_t data_size_;
+    size_t dim_;
+    size_t count_;
+    std::unordered_set<uint64_t> used_;
+    std::unordered_map<uint64_t, cv::Mat> added_;
+};
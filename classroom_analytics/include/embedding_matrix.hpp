@@ -0,0 +1,100 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+/**
+* @brief Storage precision of the gallery embeddings
+*/
+enum class EmbeddingPrecision {
+    FP32,
+    FP16,
+    INT8,
+};
+
+/**
+* @brief Parses "fp32", "fp16" or "int8"
+*
+* @return false if the text names no precision
+*/
+bool ParseEmbeddingPrecision(const std::string& text, EmbeddingPrecision* precision);
+
+/**
+* @brief Returns the name of a precision
+*/
+const char* EmbeddingPrecisionName(EmbeddingPrecision precision);
+
+/**
+* @brief Embeddings stored row by row in one contiguous buffer
+*
+* FP32 rows are multiplied with the queries by one GEMM. FP16 rows halve the
+* memory, INT8 rows are scaled per row into [-127, 127] and take a quarter of
+* it. Quantized rows are converted back to float in blocks of rows and go
+* through the same GEMM, so every build uses the vectorized kernels of OpenCV.
+*/
+class EmbeddingMatrix {
+public:
+    EmbeddingMatrix() : precision_(EmbeddingPrecision::FP32), rows_(0), cols_(0) {}
+
+    /**
+   * @brief Constructor
+   *
+   * @param rows Embeddings, one CV_32F row each
+   * @param precision Storage precision
+   */
+    EmbeddingMatrix(const cv::Mat& rows, EmbeddingPrecision precision);
+
+    /**
+   * @brief Returns number of embeddings
+   */
+    int rows() const { return rows_; }
+
+    /**
+   * @brief Returns the storage precision
+   */
+    EmbeddingPrecision precision() const { return precision_; }
+
+    /**
+   * @brief Returns size of the stored embeddings in bytes
+   */
+    size_t ByteSize() const;
+
+    /**
+   * @brief Computes the dot products of the queries with every row
+   *
+   * @param queries Queries, one CV_32F row each
+   * @param similarities Receives queries x rows dot products
+   */
+    void Similarities(const cv::Mat& queries, cv::Mat* similarities) const;
+
+private:
+    EmbeddingPrecision precision_;
+    int rows_;
+    int cols_;
+    cv::Mat fp32_;
+    /** @brief Half floats as stored by cv::convertFp16() */
+    cv::Mat fp16_;
+    cv::Mat int8_;
+    std::vector<float> scales_;
+};
+
+/**
+* @brief Measures how often quantized rows give the same nearest neighbour as the original ones
+*
+* Every sampled row is used as query against all the other rows, once in
+* float precision and once through the quantized matrix.
+*
+* @param rows L2-normalized embeddings, one CV_32F row each
+* @param quantized The same rows in lower precision
+* @param max_queries Number of rows sampled as queries
+* @return Share of queries with the same nearest neighbour, 1 with less than two rows
+*/
+double NearestNeighbourRecall(const cv::Mat& rows, const EmbeddingMatrix& quantized, int max_queries = 256);
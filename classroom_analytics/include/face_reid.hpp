@@ -5,21 +5,26 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include <opencv2/core/core.hpp>
 
 #include "cnn.hpp"
+#include "embedding_cache.hpp"
+#include "embedding_matrix.hpp"
+#include "gallery_index.hpp"
 
 struct GalleryObject {
-    std::vector<cv::Mat> embeddings;
+    size_t num_embeddings;
     std::string label;
     int id;
+    bool enrolled;
 
-    GalleryObject(const std::vector<cv::Mat>& embeddings,
-                  const std::string& label, int id)
-        : embeddings(embeddings), label(label), id(id) {}
+    GalleryObject(size_t num_embeddings,
+                  const std::string& label, int id, bool enrolled = true)
+        : num_embeddings(num_embeddings), label(label), id(id), enrolled(enrolled) {}
 };
 
 class EmbeddingsGallery {
@@ -28,14 +33,24 @@ public:
     static const int unknown_id;
     EmbeddingsGallery(const std::string& ids_list, double threshold,
                       const VectorCNN& landmarks_det,
-                      const VectorCNN& image_reid);
+                      const VectorCNN& image_reid,
+                      EmbeddingCache* cache = nullptr,
+                      const EmbeddingsGallery* previous = nullptr,
+                      const std::string& index_type = "auto",
+                      const std::string& precision = "fp32");
     size_t size() const;
     std::vector<int> GetIDsByEmbeddings(const std::vector<cv::Mat>& embeddings) const;
     std::string GetLabelByID(int id) const;
     std::vector<std::string> GetIDToLabelMap() const;
+    bool IsEnrolled(int id) const;
+    const std::vector<std::string>& GetImagePaths() const;
 
 private:
+    std::vector<std::string> image_paths;
     std::vector<int> idx_to_id;
+    EmbeddingMatrix reference_matrix;  // one L2-normalized row per reference embedding, in idx_to_id order
+    std::unique_ptr<GalleryIndex> index;  // nullptr while the references are scanned exactly
+    size_t max_identity_images = 0;  // most images of one identity, bounds the index candidates
     double reid_threshold;
     std::vector<GalleryObject> identities;
 };
@@ -0,0 +1,40 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <string>
+
+/**
+* @brief State of a file on disk, used to notice that it changed
+*
+* Modification and change times are kept in nanoseconds together with the
+* inode and the size, so an edit within the same second or a file replaced
+* by a rename changes at least one of them.
+*/
+struct FileStatus {
+    /** @brief Modification time in ns, -1 for a missing file */
+    long long mtime_ns{-1};
+    /** @brief Status change time in ns, -1 for a missing file */
+    long long ctime_ns{-1};
+    /** @brief Inode, -1 for a missing file */
+    long long inode{-1};
+    /** @brief Size in bytes, -1 for a missing file */
+    long long size{-1};
+
+    bool operator==(const FileStatus& other) const {
+        return mtime_ns == other.mtime_ns && ctime_ns == other.ctime_ns && inode == other.inode &&
+               size == other.size;
+    }
+    bool operator!=(const FileStatus& other) const { return !(*this == other); }
+};
+
+/**
+* @brief Reads the status of a file
+*
+* @param path Path to the file
+* @param status Receives the status, the default one if the file does not exist
+* @return false if the file does not exist
+*/
+bool ReadFileStatus(const std::string& path, FileStatus* status);
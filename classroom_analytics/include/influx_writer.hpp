@@ -0,0 +1,233 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spool.hpp"
+
+/**
+* @brief Settings of the InfluxDB connection
+*/
+struct InfluxConfig {
+    /** @brief Host name or IP of the InfluxDB server */
+    std::string host;
+    /** @brief HTTP port of the InfluxDB server */
+    int port{8086};
+    /** @brief Database the points are written to */
+    std::string database{"Analytics"};
+    /** @brief Number of points that triggers a flush */
+    size_t batch_size{500};
+    /** @brief Longest time a point waits in memory before it is flushed */
+    std::chrono::milliseconds flush_interval{1000};
+    /** @brief Maximal number of points kept in memory, the oldest ones are dropped beyond it */
+    size_t max_pending{100000};
+    /** @brief Send and receive timeout of the HTTP connection */
+    std::chrono::milliseconds timeout{5000};
+    /** @brief Directory of the spool that keeps points while the server is unavailable, empty to keep them in memory */
+    std::string spool_dir;
+    /** @brief Size at which a spool segment is rotated */
+    size_t spool_segment_bytes{8 << 20};
+    /** @brief Maximal number of spool segments, the oldest one is dropped beyond it */
+    size_t spool_max_segments{64};
+    /** @brief Number of spooled points per second replayed once the server is back, 0 disables replay */
+    size_t replay_rate{1000};
+};
+
+/**
+* @brief Builds one point in the InfluxDB line protocol
+*
+* Tags have to be added before fields. Keys and values are escaped as the
+* protocol requires, numeric fields are written as floats.
+*/
+class LinePoint {
+public:
+    /**
+   * @brief Constructor
+   *
+   * @param measurement Name of the measurement
+   */
+    explicit LinePoint(const std::string& measurement);
+
+    /**
+   * @brief Adds a tag, empty values are skipped because InfluxDB rejects them
+   */
+    LinePoint& Tag(const std::string& key, const std::string& value);
+
+    /**
+   * @brief Adds a float field, NaN and infinite values are skipped
+   */
+    LinePoint& Field(const std::string& key, double value);
+
+    /**
+   * @brief Adds a string field
+   */
+    LinePoint& Field(const std::string& key, const std::string& value);
+
+    /**
+   * @brief Sets the timestamp of the point, written with millisecond precision
+   */
+    LinePoint& Time(std::chrono::system_clock::time_point time);
+
+    /**
+   * @brief Returns the point as one line of the protocol, empty if it has no fields
+   */
+    std::string Line() const;
+
+private:
+    std::string key_;
+    std::string fields_;
+    std::string time_;
+};
+
+/**
+* @brief Minimal HTTP/1.1 client that keeps one connection to a server alive
+*
+* The connection is opened on the first request and reused by the following
+* ones. It is dropped and reopened after any error or when the server asks to
+* close it. Not thread safe.
+*/
+class HttpConnection {
+public:
+    /**
+   * @brief Constructor
+   *
+   * @param host Host name or IP of the server
+   * @param port TCP port of the server
+   * @param timeout Send and receive timeout
+   */
+    HttpConnection(const std::string& host, int port, std::chrono::milliseconds timeout);
+    ~HttpConnection();
+
+    HttpConnection(const HttpConnection&) = delete;
+    HttpConnection& operator=(const HttpConnection&) = delete;
+
+    /**
+   * @brief Sends a POST request and waits for the response
+   *
+   * @param target Path and query of the request
+   * @param content_type Value of the Content-Type header
+   * @param body Request body
+   * @param response_body Receives the response body, may be nullptr
+   * @return HTTP status code, or -1 if the server could not be reached
+   */
+    int Post(const std::string& target, const std::string& content_type,
+             const std::string& body, std::string* response_body = nullptr);
+
+    /**
+   * @brief Closes the connection, the next request opens a new one
+   */
+    void Close();
+
+private:
+    bool Connect();
+    bool SendAll(const std::string& data);
+    bool ReadLine(std::string* line);
+    bool ReadBytes(size_t count, std::string* data);
+    bool Fill();
+
+    const std::string host_;
+    const int port_;
+    const std::chrono::milliseconds timeout_;
+    int fd_;
+    std::string buffer_;
+};
+
+/**
+* @brief Batched writer of line protocol points to InfluxDB
+*
+* Write() only appends the point to an in-memory queue, so the vision
+* pipeline never waits for the database. A background thread sends the
+* queued points in one request over a keep-alive connection once batch_size
+* of them are waiting or flush_interval has passed.
+*
+* While the server is down, or too slow to take the points of one interval
+* within the next one, the points go to the on-disk spool, if configured, or
+* stay queued in memory up to max_pending. The server is retried once per
+* interval; once it answers again the spool is replayed at replay_rate
+* points per second next to the live points. A missing database is created
+* again. Close() sends whatever is left and stops the thread, points still
+* spooled are replayed by the next run.
+*/
+class InfluxWriter {
+public:
+    /**
+   * @brief Constructor, starts the flush thread
+   */
+    explicit InfluxWriter(const InfluxConfig& config);
+    ~InfluxWriter();
+
+    InfluxWriter(const InfluxWriter&) = delete;
+    InfluxWriter& operator=(const InfluxWriter&) = delete;
+
+    /**
+   * @brief Creates the database if it does not exist yet, blocks until the server answers
+   *
+   * @return false if the server could not be reached or refused the query
+   */
+    bool CreateDatabase();
+
+    /**
+   * @brief Queues a point for writing, never blocks on the network
+   */
+    void Write(const LinePoint& point);
+
+    /**
+   * @brief Queues a point given as one line of the protocol
+   */
+    void Write(std::string line);
+
+    /**
+   * @brief Flushes the queued points and stops the flush thread
+   */
+    void Close();
+
+    /**
+   * @brief Returns number of points accepted by the server
+   */
+    size_t Written() const { return written_.load(); }
+
+    /**
+   * @brief Returns number of points dropped, either rejected by the server or over the memory and spool limits
+   */
+    size_t Dropped() const { return dropped_.load(); }
+
+    /**
+   * @brief Returns number of points written to the spool
+   */
+    size_t Spooled() const { return spooled_.load(); }
+
+private:
+    int QueryCreateDatabase(HttpConnection& connection, std::string* response);
+    void FlushLoop();
+    bool Send(const std::vector<std::string>& points, size_t begin, size_t end);
+    void Spill(std::vector<std::string>& points, size_t begin, bool closing);
+    void Replay(bool probe);
+
+    const InfluxConfig config_;
+    HttpConnection connection_;
+    std::unique_ptr<LineSpool> spool_;
+    std::deque<std::string> pending_;
+    bool closed_;
+    bool failing_;
+    std::atomic<bool> database_ready_;
+    double replay_tokens_;
+    std::chrono::steady_clock::time_point replay_refill_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::atomic<size_t> written_;
+    std::atomic<size_t> dropped_;
+    std::atomic<size_t> spooled_;
+    std::thread flusher_;
+};
@@ -0,0 +1,98 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "attendance.hpp"
+#include "cnn.hpp"
+#include "embedding_cache.hpp"
+#include "face_reid.hpp"
+
+/**
+* @brief Face gallery that follows the changes of its file while the pipelines run
+*
+* Identities are added, replaced or removed by editing the gallery file or
+* replacing its images. A background thread checks the status of the file
+* and of its images, see FileStatus, at most once per check interval. When
+* one of them changed, the gallery is rebuilt with the ids of the current
+* one, the embeddings of unchanged images coming from the cache, and
+* published together with its roster by an atomic snapshot swap. Readers
+* keep using the snapshot they took, so matching never waits for an update.
+*/
+class LiveGallery {
+public:
+    /**
+   * @brief Constructor, builds the gallery and starts watching its file
+   *
+   * @param path Path to the gallery file
+   * @param threshold Reid distance above which a face is unknown
+   * @param landmarks_det Landmarks network
+   * @param image_reid Reid network
+   * @param cache Embedding cache, may be nullptr
+   * @param index_type Index of the references, see CreateGalleryIndex()
+   * @param precision Storage precision of the references, see ParseEmbeddingPrecision()
+   * @param check_interval Time between two checks of the files
+   */
+    LiveGallery(const std::string& path, double threshold,
+                const VectorCNN& landmarks_det, const VectorCNN& image_reid,
+                EmbeddingCache* cache, const std::string& index_type = "auto",
+                const std::string& precision = "fp32",
+                std::chrono::seconds check_interval = std::chrono::seconds(5));
+
+    /**
+   * @brief Destructor, stops watching
+   */
+    ~LiveGallery();
+
+    LiveGallery(const LiveGallery&) = delete;
+    LiveGallery& operator=(const LiveGallery&) = delete;
+
+    /**
+   * @brief Returns the current gallery
+   */
+    std::shared_ptr<const EmbeddingsGallery> Current() const;
+
+    /**
+   * @brief Returns the roster of the current gallery
+   */
+    SharedRoster& GetRoster() { return roster_; }
+
+    /**
+   * @brief Rebuilds the gallery if its file or one of its images changed
+   *
+   * @return true if a new gallery has been published
+   */
+    bool Reload();
+
+private:
+    void WatchLoop();
+    uint64_t Signature(const EmbeddingsGallery& gallery) const;
+    static std::shared_ptr<const Roster> MakeRoster(const EmbeddingsGallery& gallery);
+
+    const std::string path_;
+    const double threshold_;
+    const VectorCNN& landmarks_det_;
+    const VectorCNN& image_reid_;
+    EmbeddingCache* cache_;
+    const std::string index_type_;
+    const std::string precision_;
+    const std::chrono::seconds check_interval_;
+    std::shared_ptr<const EmbeddingsGallery> gallery_;
+    SharedRoster roster_;
+    std::mutex reload_mutex_;
+    uint64_t signature_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopped_;
+    std::thread watcher_;
+};
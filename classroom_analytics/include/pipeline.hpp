@@ -0,0 +1,208 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+* @brief Fixed-capacity FIFO queue that joins two pipeline stages
+*
+* The producer blocks in Push() while the queue is full, which propagates
+* backpressure up the pipeline instead of letting frames pile up in memory.
+* Close() wakes up both sides: Push() starts failing immediately and Pop()
+* fails once the remaining items have been drained.
+*/
+template <typename T>
+class BoundedQueue {
+public:
+    /**
+   * @brief Constructor
+   *
+   * @param capacity Maximal number of items waiting in the queue
+   */
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity > 0 ? capacity : 1), closed_(false) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+   * @brief Appends an item, waiting for free space if the queue is full
+   *
+   * @return false if the queue has been closed and the item was dropped
+   */
+    bool Push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+   * @brief Takes the oldest item, waiting for one if the queue is empty
+   *
+   * @return false if the queue has been closed and drained
+   */
+    bool Pop(T* item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+        if (items_.empty()) {
+            return false;
+        }
+        *item = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /**
+   * @brief Takes the oldest item, waiting at most timeout for one
+   *
+   * @return false if no item arrived in time or the queue has been closed and drained
+   */
+    bool PopFor(T* item, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait_for(lock, timeout, [this] { return closed_ || !items_.empty(); });
+        if (items_.empty()) {
+            return false;
+        }
+        *item = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /**
+   * @brief Indicates whether the queue has been closed and holds no more items
+   */
+    bool Drained() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_ && items_.empty();
+    }
+
+    /**
+   * @brief Stops the queue and wakes up all waiting producers and consumers
+   */
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    /**
+   * @brief Returns number of items waiting in the queue
+   */
+    size_t Size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+private:
+    const size_t capacity_;
+    bool closed_;
+    std::deque<T> items_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+};
+
+/**
+* @brief Fixed-capacity ring of shared items with a "latest item wins" policy
+*
+* Publish() never blocks: once the ring is full the oldest slot is overwritten.
+* WaitLatest() sleeps until something newer than the last consumed item has been
+* published and returns only the newest one, the skipped items are counted as
+* dropped. T is meant to be a pointer to immutable data, e.g.
+* std::shared_ptr<const Frame>, so handing out an item never copies the payload.
+*/
+template <typename T>
+class LatestRing {
+public:
+    /**
+   * @brief Constructor
+   *
+   * @param capacity Number of slots in the ring
+   */
+    explicit LatestRing(size_t capacity)
+        : slots_(capacity > 0 ? capacity : 1), written_(0), read_(0), dropped_(0), closed_(false) {}
+
+    LatestRing(const LatestRing&) = delete;
+    LatestRing& operator=(const LatestRing&) = delete;
+
+    /**
+   * @brief Stores an item, overwriting the oldest slot if the ring is full
+   */
+    void Publish(T item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_) {
+                return;
+            }
+            slots_[written_ % slots_.size()] = std::move(item);
+            ++written_;
+        }
+        published_.notify_all();
+    }
+
+    /**
+   * @brief Waits for an item newer than the previously returned one and takes the newest
+   *
+   * @return false if the ring has been closed and holds nothing new
+   */
+    bool WaitLatest(T* item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        published_.wait(lock, [this] { return closed_ || written_ > read_; });
+        if (written_ == read_) {
+            return false;
+        }
+        dropped_ += written_ - read_ - 1;
+        read_ = written_;
+        *item = slots_[(written_ - 1) % slots_.size()];
+        return true;
+    }
+
+    /**
+   * @brief Stops the ring and wakes up all waiting consumers
+   */
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        published_.notify_all();
+    }
+
+    /**
+   * @brief Returns number of items that were overwritten or skipped unread
+   */
+    size_t Dropped() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return dropped_;
+    }
+
+private:
+    std::vector<T> slots_;
+    size_t written_;
+    size_t read_;
+    size_t dropped_;
+    bool closed_;
+    mutable std::mutex mutex_;
+    std::condition_variable published_;
+};
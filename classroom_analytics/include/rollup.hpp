@@ -0,0 +1,90 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "influx_writer.hpp"
+
+/**
+* @brief Aggregates samples into tumbling time windows of several lengths
+*
+* Every window keeps min, max, mean and last value of each field per series,
+* where a series is one combination of tag values. The windows are aligned to
+* multiples of their length since the epoch, so the rollups of all classrooms
+* line up. A window is emitted once a sample or a Flush() passes its end, as
+* one point with the tag window="<length>s", the mean under the field name,
+* the other statistics under <field>_min, <field>_max and <field>_last, the
+* number of samples under "samples" and the start of the window as timestamp.
+*/
+class WindowedRollup {
+public:
+    typedef std::vector<std::pair<std::string, std::string>> Tags;
+    typedef std::vector<std::pair<std::string, double>> Fields;
+
+    /**
+   * @brief Constructor
+   *
+   * @param measurement Measurement of the emitted points
+   * @param windows Window lengths, non-positive ones are ignored
+   */
+    WindowedRollup(const std::string& measurement, const std::vector<std::chrono::seconds>& windows);
+
+    /**
+   * @brief Indicates whether there is at least one window
+   */
+    bool Enabled() const { return !windows_.empty(); }
+
+    /**
+   * @brief Adds a sample of every field
+   *
+   * @param tags Tags of the series
+   * @param fields Values of the sample
+   * @param time Time of the sample, has to be non-decreasing within a series
+   * @param points Receives the windows closed by the sample
+   */
+    void Add(const Tags& tags, const Fields& fields, std::chrono::system_clock::time_point time,
+             std::vector<LinePoint>* points);
+
+    /**
+   * @brief Emits all windows that ended before the given time
+   */
+    void Flush(std::chrono::system_clock::time_point time, std::vector<LinePoint>* points);
+
+    /**
+   * @brief Emits all windows including the incomplete ones
+   */
+    void FlushAll(std::vector<LinePoint>* points);
+
+private:
+    struct Stats {
+        double min;
+        double max;
+        double sum;
+        double last;
+        size_t count;
+    };
+
+    struct Window {
+        long long start_ms;
+        size_t samples;
+        std::map<std::string, Stats> fields;
+    };
+
+    struct Series {
+        Tags tags;
+        std::vector<Window> windows;
+    };
+
+    void Emit(const Series& series, size_t window_idx, std::vector<LinePoint>* points) const;
+
+    const std::string measurement_;
+    std::vector<long long> windows_;
+    std::map<std::string, Series> series_;
+};
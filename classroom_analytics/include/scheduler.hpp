@@ -0,0 +1,74 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cstddef>
+
+/**
+* @brief Run intervals of the networks, in frames
+*/
+struct CadenceConfig {
+    /** @brief Person/action detection */
+    int action_detection{1};
+    /** @brief Face detection */
+    int face_detection{1};
+    /** @brief Landmarks regression and face reidentification */
+    int face_reid{1};
+    /** @brief Head pose estimation */
+    int head_pose{1};
+    /** @brief Emotions recognition */
+    int emotions{1};
+    /** @brief Stretch the intervals while the results do not change */
+    bool adaptive{false};
+};
+
+/**
+* @brief Decides on which frames a network runs
+*
+* A network runs on the first frame and then whenever interval frames have
+* passed since its last run. On the frames in between the callers carry the
+* previous results forward, e.g. through the trackers. In adaptive mode the
+* interval grows by one frame after every run that found as many objects as
+* the run before, up to max_factor times the base interval, and snaps back to
+* the base interval as soon as the number of objects changes.
+*/
+class Cadence {
+public:
+    /**
+   * @brief Constructor
+   *
+   * @param interval Base run interval in frames
+   * @param adaptive Adapt the interval to the scene
+   */
+    explicit Cadence(int interval = 1, bool adaptive = false);
+
+    /**
+   * @brief Indicates whether the network has to run on the frame
+   *
+   * Frames have to be passed in increasing order. A positive answer counts as a run.
+   */
+    bool ShouldRun(size_t frame_idx);
+
+    /**
+   * @brief Reports the number of objects found by a run
+   */
+    void Feedback(size_t num_objects);
+
+    /**
+   * @brief Returns the current run interval in frames
+   */
+    int Interval() const { return interval_; }
+
+    static const int max_factor = 4;
+
+private:
+    int base_interval_;
+    int interval_;
+    bool adaptive_;
+    bool has_run_;
+    size_t last_run_;
+    bool has_feedback_;
+    size_t last_num_objects_;
+};
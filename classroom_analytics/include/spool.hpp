@@ -0,0 +1,94 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+* @brief Append-only on-disk queue of text lines split into rotated segment files
+*
+* Lines are appended to the newest segment, a new segment is started once the
+* current one reaches segment_bytes. Reading starts at the oldest segment; lines
+* handed out by Read() are consumed only by Commit(), so a failed replay leaves
+* them in place. Fully consumed segments are deleted, and the read position is
+* kept in a file so that the spool survives a restart. If more than max_segments
+* segments pile up, the oldest one is deleted with its lines. Not thread safe.
+*/
+class LineSpool {
+public:
+    /**
+   * @brief Constructor
+   *
+   * @param directory Directory of the segment files, created if missing
+   * @param segment_bytes Size at which a segment is rotated
+   * @param max_segments Maximal number of segments kept on disk
+   */
+    LineSpool(const std::string& directory, size_t segment_bytes, size_t max_segments);
+
+    LineSpool(const LineSpool&) = delete;
+    LineSpool& operator=(const LineSpool&) = delete;
+
+    /**
+   * @brief Creates the directory and picks up the segments left by a previous run
+   *
+   * @return false if the directory cannot be created
+   */
+    bool Open();
+
+    /**
+   * @brief Appends lines, which must not contain line breaks
+   *
+   * @return false if the lines could not be written
+   */
+    bool Append(std::vector<std::string>::const_iterator begin, std::vector<std::string>::const_iterator end);
+
+    /**
+   * @brief Reads up to max_lines lines of the oldest segment without consuming them
+   *
+   * @return false if there is nothing to read
+   */
+    bool Read(size_t max_lines, std::vector<std::string>* lines);
+
+    /**
+   * @brief Consumes the lines returned by the last Read()
+   */
+    void Commit();
+
+    /**
+   * @brief Indicates whether all appended lines have been consumed
+   */
+    bool Empty() const;
+
+    /**
+   * @brief Returns number of segments deleted unread because max_segments was exceeded
+   */
+    size_t DroppedSegments() const { return dropped_segments_; }
+
+private:
+    struct Segment {
+        unsigned long long id;
+        size_t size;
+    };
+
+    std::string SegmentPath(unsigned long long id) const;
+    bool StartSegment();
+    void RemoveFront();
+    void SaveOffset();
+
+    const std::string directory_;
+    const size_t segment_bytes_;
+    const size_t max_segments_;
+    std::deque<Segment> segments_;
+    unsigned long long next_id_;
+    std::ofstream writer_;
+    bool writing_;
+    size_t read_offset_;
+    size_t next_offset_;
+    size_t dropped_segments_;
+};
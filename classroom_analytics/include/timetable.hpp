@@ -0,0 +1,80 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "file_status.hpp"
+
+/**
+* @brief One class of the timetable
+*
+* Times are minutes since Monday 00:00 local time.
+*/
+struct TimetableSlot {
+    /** @brief Subject taught in the slot */
+    std::string subject;
+    /** @brief First minute of the slot */
+    int start;
+    /** @brief Minute after the last one of the slot */
+    int end;
+};
+
+/**
+* @brief Timetable file parsed into a sorted index of weekly intervals
+*
+* Every line of the file is one class:
+*
+*     Subject-H                        the hour H:00-H+1:00 of every day, 0 <= H <= 23
+*     Subject-HH:MM-HH:MM              the given interval of every day
+*     Subject-HH:MM-HH:MM-Mon,Wed,Fri  the given interval of the given weekdays
+*
+* Empty lines and lines starting with # are skipped. Slots are not expected
+* to overlap. A lookup is a binary search over the slots of the week, and its
+* answer is cached until the next slot boundary. The file is checked for
+* changes at most once per check interval and reparsed only if its
+* modification time, in nanoseconds, inode or size changed. Thread safe.
+*/
+class Timetable {
+public:
+    /**
+   * @brief Constructor, the file is loaded by the first lookup
+   *
+   * @param path Path to the timetable file
+   * @param check_interval Time between two checks of the file
+   */
+    explicit Timetable(const std::string& path,
+                       std::chrono::seconds check_interval = std::chrono::seconds(5));
+
+    /**
+   * @brief Finds the slot at the given time
+   *
+   * @param time Time of interest
+   * @param slot Receives the slot
+   * @return false if no class takes place at that time
+   */
+    bool Lookup(std::chrono::system_clock::time_point time, TimetableSlot* slot);
+
+private:
+    void ReloadIfChanged(std::chrono::system_clock::time_point time);
+    bool Load();
+
+    const std::string path_;
+    const std::chrono::seconds check_interval_;
+    std::mutex mutex_;
+    std::vector<TimetableSlot> slots_;
+    bool checked_;
+    bool missing_;
+    FileStatus file_status_;
+    std::chrono::system_clock::time_point next_check_;
+    bool cached_;
+    int cached_slot_;
+    std::chrono::system_clock::time_point cached_from_;
+    std::chrono::system_clock::time_point cached_until_;
+};
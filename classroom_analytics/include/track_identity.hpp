@@ -0,0 +1,125 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "tracker.hpp"
+
+/**
+* @brief When the identity of a face track is trusted without reid
+*/
+struct TrackIdentityParams {
+    /** @brief Frames a confirmed identity is trusted before reid checks it again, 0 runs reid on every face */
+    size_t verify_every{30};
+    /** @brief Reid results in a row with the same label that confirm an identity */
+    int min_confirmations{3};
+    /** @brief IoU of the face box with its box at the last check that is still the same face */
+    float min_box_iou{0.6f};
+    /** @brief Total quality at which the mean embedding of a track stops growing and older faces fade out, 0 matches single faces */
+    float max_track_weight{10.0f};
+};
+
+/**
+* @brief Face reid ran on, with what it returned
+*/
+struct VerifiedFace {
+    /** @brief Box of the face */
+    cv::Rect rect;
+    /** @brief Label the gallery gave the embedding of the face alone */
+    int label;
+    /** @brief Embedding of the face alone */
+    cv::Mat embedding;
+    /** @brief Weight of the embedding, see FaceQuality() */
+    float quality;
+};
+
+/**
+* @brief Returns how much an embedding of the face can be relied on, in [0, 1]
+*
+* The detection confidence, lowered for faces smaller than 64 pixels, whose
+* embeddings are blurry.
+*/
+float FaceQuality(const cv::Rect& rect, float confidence);
+
+/**
+* @brief Identities of the face tracks of one classroom, used to skip reid
+*
+* The track stage records for every track the label reid gave it and when,
+* the face attributes stage asks for every detected face whether the track
+* it overlaps is trusted. A track is trusted once reid confirmed its label
+* several times in a row, the tracker agrees with it, it was checked within
+* the last frames and its box has not moved much since. New, uncertain and
+* merged tracks, which have no record yet or a different label, always go
+* through reid. The track stage runs a few frames behind the face
+* attributes stage, so the faces are matched with the latest known boxes.
+*
+* Every track also keeps the quality-weighted running mean of the
+* normalized embeddings reid computed for it, in one preallocated vector.
+* A face is matched with the gallery through the mean of its track, which
+* is steadier than the embedding of a single frame. Confirmations only count
+* the labels of the single embeddings, so a track cannot confirm the label
+* its own mean leans to, and when those give the track a new label the mean
+* starts over. Thread safe.
+*/
+class TrackIdentityCache {
+public:
+    /**
+   * @brief Constructor
+   */
+    explicit TrackIdentityCache(const TrackIdentityParams& params);
+
+    /**
+   * @brief Returns the trusted label of the track a face belongs to
+   *
+   * @param face Box of the detected face
+   * @param frame_idx Frame of the face
+   * @return TrackedObject::UNKNOWN_LABEL_IDX if reid has to run on the face
+   */
+    int TrustedLabel(const cv::Rect& face, size_t frame_idx) const;
+
+    /**
+   * @brief Combines the embedding of a face with the mean embedding of its track
+   *
+   * @param face Box of the detected face
+   * @param embedding Embedding of the face
+   * @param quality Weight of the embedding, see FaceQuality()
+   * @return Normalized embedding to match with the gallery, empty if the track has no mean yet
+   */
+    cv::Mat Aggregate(const cv::Rect& face, const cv::Mat& embedding, float quality) const;
+
+    /**
+   * @brief Records the face tracks of a frame
+   *
+   * @param tracked_faces Tracked faces of the frame, with the labels of their tracks
+   * @param verified Faces reid ran on in this frame
+   * @param frame_idx Frame of the faces
+   */
+    void Update(const TrackedObjects& tracked_faces, const std::vector<VerifiedFace>& verified, size_t frame_idx);
+
+private:
+    struct TrackIdentity {
+        cv::Rect rect;
+        int track_label;
+        int verified_label;
+        cv::Rect verified_rect;
+        size_t verified_frame;
+        int confirmations;
+        cv::Mat mean_embedding;
+        int mean_label;
+        float weight;
+    };
+
+    const TrackIdentity* FindTrack(const cv::Rect& face) const;
+
+    const TrackIdentityParams params_;
+    mutable std::mutex mutex_;
+    std::unordered_map<int, TrackIdentity> tracks_;
+};
@@ -21,31 +21,6 @@ bool SortScorePairDescend(const std::pair<float, T>& pair1,
     return pair1.first > pair2.first;
 }
 
-void ActionDetection::submitRequest() {
-    if (!enqueued_frames_) return;
-    enqueued_frames_ = 0;
-    results_fetched_ = false;
-    results.clear();
-    BaseCnnDetection::submitRequest();
-}
-
-void ActionDetection::enqueue(const cv::Mat &frame) {
-    if (!enabled()) return;
-
-    if (!request) {
-        request = net_.CreateInferRequestPtr();
-    }
-
-    width_ = frame.cols;
-    height_ = frame.rows;
-
-    Blob::Ptr inputBlob = request->GetBlob(input_name_);
-
-    matU8ToBlob<uint8_t>(frame, inputBlob);
-
-    enqueued_frames_ = 1;
-}
-
 ActionDetection::ActionDetection(const ActionDetectorConfig& config)
     : BaseCnnDetection(config.enabled, config.is_async), config_(config) {
     if (config.enabled) {
@@ -75,10 +50,18 @@ ActionDetection::ActionDetection(const ActionDetectorConfig& config)
         }
 
         input_name_ = inputInfo.begin()->first;
-        net_ = config_.plugin.LoadNetwork(net_reader.getNetwork(), config_.device,{});
+        net_ = config_.plugin.LoadNetwork(net_reader.getNetwork(), config_.device,
+                                          ThroughputConfig(config_.device, NumStreams(config_)));
     }
 }
 
+ActionDetection::ActionDetection(const ActionDetection& other)
+    : BaseCnnDetection(other), config_(other.config_), net_(other.net_),
+      input_name_(other.input_name_) {
+    // the pool of infer requests is created on the first SubmitFrame()
+    request.reset();
+}
+
 std::vector<int> ieSizeToVector(const SizeVector& ie_output_dims) {
     std::vector<int> blob_sizes(ie_output_dims.size(), 0);
     for (size_t i = 0; i < blob_sizes.size(); ++i) {
@@ -87,31 +70,54 @@ std::vector<int> ieSizeToVector(const SizeVector& ie_output_dims) {
     return blob_sizes;
 }
 
-void ActionDetection::fetchResults() {
+void ActionDetection::SubmitFrame(const cv::Mat &frame, size_t frame_id) {
     if (!enabled()) return;
-    results.clear();
-    if (results_fetched_) return;
-    results_fetched_ = true;
 
-    const cv::Mat priorbox_out(ieSizeToVector(request->GetBlob(config_.priorbox_blob_name)->getTensorDesc().getDims()),
-                               CV_32F, request->GetBlob(config_.priorbox_blob_name)->buffer());
+    if (!pool_.Created()) {
+        pool_.Create(net_, config_.num_requests);
+        if (!request) {
+            // performance counts are reported for the first request of the pool
+            request = pool_.Free();
+        }
+    }
+
+    Blob::Ptr inputBlob = pool_.Free()->GetBlob(input_name_);
+
+    matU8ToBlob<uint8_t>(frame, inputBlob);
+
+    pool_.Start(frame_id, frame.size());
+}
+
+size_t ActionDetection::FetchOldest(DetectedActions* detections) {
+    const InFlightRequest& oldest = pool_.WaitOldest();
+    detections->clear();
+    ParseDetections(*oldest.request, oldest.frame_size, detections);
+    const size_t frame_id = oldest.frame_id;
+    pool_.Release();
+    return frame_id;
+}
+
+void ActionDetection::ParseDetections(InferRequest& request, const cv::Size& frame_size,
+                                      DetectedActions* detections) const {
+    const cv::Mat priorbox_out(ieSizeToVector(request.GetBlob(config_.priorbox_blob_name)->getTensorDesc().getDims()),
+                               CV_32F, request.GetBlob(config_.priorbox_blob_name)->buffer());
 
-    const cv::Mat loc_out(ieSizeToVector(request->GetBlob(config_.loc_blob_name)->getTensorDesc().getDims()),
-                          CV_32F, request->GetBlob(config_.loc_blob_name)->buffer());
+    const cv::Mat loc_out(ieSizeToVector(request.GetBlob(config_.loc_blob_name)->getTensorDesc().getDims()),
+                          CV_32F, request.GetBlob(config_.loc_blob_name)->buffer());
 
-    const cv::Mat main_conf_out(ieSizeToVector(request->GetBlob(config_.detection_conf_blob_name)->getTensorDesc().getDims()),
-                                CV_32F, request->GetBlob(config_.detection_conf_blob_name)->buffer());
+    const cv::Mat main_conf_out(ieSizeToVector(request.GetBlob(config_.detection_conf_blob_name)->getTensorDesc().getDims()),
+                                CV_32F, request.GetBlob(config_.detection_conf_blob_name)->buffer());
 
     std::vector<cv::Mat> add_conf_out;
     for (int i = 0; i < config_.num_anchors; ++i) {
         const auto blob_name = config_.action_conf_blob_name_prefix + std::to_string(i + 1);
-        add_conf_out.emplace_back(ieSizeToVector(request->GetBlob(blob_name)->getTensorDesc().getDims()),
-                                  CV_32F, request->GetBlob(blob_name)->buffer());
+        add_conf_out.emplace_back(ieSizeToVector(request.GetBlob(blob_name)->getTensorDesc().getDims()),
+                                  CV_32F, request.GetBlob(blob_name)->buffer());
     }
 
     /** Parse detections **/
     GetDetections(loc_out, main_conf_out, priorbox_out, add_conf_out,
-                  cv::Size(width_, height_), &results);
+                  frame_size, detections);
 }
 
 inline ActionDetection::NormalizedBBox
@@ -0,0 +1,97 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "attendance.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+Roster::Roster(const std::vector<std::string>& labels) : labels_(labels), enrolled_(labels.size(), true) {
+    ids_.reserve(labels_.size());
+    for (size_t id = 0; id < labels_.size(); id++) {
+        ids_.emplace(labels_[id], static_cast<int>(id));
+    }
+}
+
+Roster::Roster(const std::vector<std::string>& labels, const std::vector<bool>& enrolled) : Roster(labels) {
+    enrolled_ = enrolled;
+    enrolled_.resize(labels_.size(), true);
+}
+
+int Roster::Find(const std::string& label) const {
+    auto it = ids_.find(label);
+    return it != ids_.end() ? it->second : -1;
+}
+
+SharedRoster::SharedRoster(std::shared_ptr<const Roster> initial) : roster_(std::move(initial)) {}
+
+std::shared_ptr<const Roster> SharedRoster::Current() const {
+    return std::atomic_load(&roster_);
+}
+
+void SharedRoster::Publish(std::shared_ptr<const Roster> roster) {
+    std::atomic_store(&roster_, std::move(roster));
+}
+
+AttendanceTracker::AttendanceTracker() : active_(false) {}
+
+bool AttendanceTracker::SwitchSession(const std::string& session, const std::string& subject,
+                                      const std::shared_ptr<const Roster>& roster,
+                                      std::chrono::system_clock::time_point now, AttendanceReport* report) {
+    if (active_ && session == session_) {
+        return false;
+    }
+    bool ended = EndSession(now, report);
+
+    const size_t num_students = roster->size();
+    roster_ = roster;
+    active_ = true;
+    session_ = session;
+    subject_ = subject;
+    start_ = now;
+    present_.assign((num_students + 63) / 64, 0);
+    first_seen_.assign(num_students, now);
+    last_seen_.assign(num_students, now);
+    return ended;
+}
+
+bool AttendanceTracker::EndSession(std::chrono::system_clock::time_point now, AttendanceReport* report) {
+    if (!active_) {
+        return false;
+    }
+    active_ = false;
+    report->roster = roster_;
+    report->subject = subject_;
+    report->start = start_;
+    report->end = now;
+    report->records.clear();
+    report->records.reserve(first_seen_.size());
+    for (size_t id = 0; id < first_seen_.size(); id++) {
+        if (!roster_->Enrolled(static_cast<int>(id))) {
+            continue;
+        }
+        bool present = (present_[id / 64] >> (id % 64)) & 1;
+        report->records.push_back({static_cast<int>(id), present, first_seen_[id], last_seen_[id]});
+    }
+    return true;
+}
+
+void AttendanceTracker::Observe(const std::vector<int>& ids, std::chrono::system_clock::time_point now) {
+    if (!active_) {
+        return;
+    }
+    for (int id : ids) {
+        if (id < 0 || static_cast<size_t>(id) >= first_seen_.size()) {
+            continue;
+        }
+        uint64_t& word = present_[id / 64];
+        const uint64_t bit = uint64_t(1) << (id % 64);
+        if (!(word & bit)) {
+            word |= bit;
+            first_seen_[id] = now;
+        }
+        last_seen_[id] = now;
+    }
+}
@@ -7,6 +7,9 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <deque>
+#include <map>
+#include <utility>
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
@@ -15,6 +18,78 @@
 
 using namespace InferenceEngine;
 
+namespace {
+
+// Layer times of all requests added up, the other fields come from the first request
+std::map<std::string, InferenceEngineProfileInfo> SumPerformanceCounts(
+        const std::vector<InferRequest::Ptr>& requests) {
+    std::map<std::string, InferenceEngineProfileInfo> total = requests.front()->GetPerformanceCounts();
+    for (size_t i = 1; i < requests.size(); i++) {
+        for (const auto& layer : requests[i]->GetPerformanceCounts()) {
+            auto known = total.find(layer.first);
+            if (known == total.end()) {
+                total.insert(layer);
+            } else {
+                known->second.realTime_uSec += layer.second.realTime_uSec;
+                known->second.cpu_uSec += layer.second.cpu_uSec;
+            }
+        }
+    }
+    return total;
+}
+
+}  // anonymous namespace
+
+std::map<std::string, std::string> ThroughputConfig(const std::string& device, int num_streams) {
+    std::map<std::string, std::string> config;
+    const int hardware_threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (hardware_threads > 0) {
+        num_streams = std::min(num_streams, hardware_threads);
+    }
+    if (num_streams > 1 && device.find("CPU") != std::string::npos) {
+        config[PluginConfigParams::KEY_CPU_THROUGHPUT_STREAMS] = std::to_string(num_streams);
+    }
+    return config;
+}
+
+void InferRequestPool::Create(ExecutableNetwork& net, size_t size) {
+    requests_.resize(std::max<size_t>(size, 1));
+    for (auto& slot : requests_) {
+        slot.request = net.CreateInferRequestPtr();
+    }
+    head_ = 0;
+    in_flight_ = 0;
+}
+
+const InferRequest::Ptr& InferRequestPool::Free() const {
+    if (Full()) {
+        THROW_IE_EXCEPTION << "All infer requests are in flight";
+    }
+    return requests_[(head_ + in_flight_) % requests_.size()].request;
+}
+
+void InferRequestPool::Start(size_t frame_id, const cv::Size& frame_size) {
+    InFlightRequest& slot = requests_[(head_ + in_flight_) % requests_.size()];
+    slot.frame_id = frame_id;
+    slot.frame_size = frame_size;
+    slot.request->StartAsync();
+    in_flight_++;
+}
+
+const InFlightRequest& InferRequestPool::WaitOldest() {
+    if (!in_flight_) {
+        THROW_IE_EXCEPTION << "No infer request in flight";
+    }
+    InFlightRequest& slot = requests_[head_];
+    slot.request->Wait(IInferRequest::WaitMode::RESULT_READY);
+    return slot;
+}
+
+void InferRequestPool::Release() {
+    head_ = (head_ + 1) % requests_.size();
+    in_flight_--;
+}
+
 CnnDLSDKBase::CnnDLSDKBase(const Config& config) : config_(config) {}
 
 bool CnnDLSDKBase::Enabled() const {
@@ -48,8 +123,33 @@ void CnnDLSDKBase::Load() {
         output_blobs_names_.push_back(item.first);
     }
 
-    executable_network_ = config_.plugin.LoadNetwork(net_reader.getNetwork(),config_.device, {});
-    infer_request_ = executable_network_.CreateInferRequest();
+    executable_network_ = config_.plugin.LoadNetwork(net_reader.getNetwork(),config_.device,
+                                                     ThroughputConfig(config_.device, NumStreams(config_)));
+    for (int i = 0; i < std::max(config_.num_requests, 1); i++) {
+        infer_requests_.push_back(executable_network_.CreateInferRequestPtr());
+    }
+    idle_requests_ = infer_requests_;
+}
+
+InferRequest::Ptr CnnDLSDKBase::AcquireRequest(bool wait) const {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    if (wait) {
+        idle_cv_.wait(lock, [this] { return !idle_requests_.empty(); });
+    }
+    if (idle_requests_.empty()) {
+        return nullptr;
+    }
+    InferRequest::Ptr request = idle_requests_.back();
+    idle_requests_.pop_back();
+    return request;
+}
+
+void CnnDLSDKBase::ReleaseRequest(const InferRequest::Ptr& request) const {
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        idle_requests_.push_back(request);
+    }
+    idle_cv_.notify_one();
 }
 
 void CnnDLSDKBase::InferBatch(
@@ -58,34 +158,83 @@ void CnnDLSDKBase::InferBatch(
     if (!config_.enabled) {
         return;
     }
-    Blob::Ptr input = infer_request_.GetBlob(input_blob_name_);
-    const size_t batch_size = input->getTensorDesc().getDims()[0];
+    struct Chunk {
+        InferRequest::Ptr request;
+        size_t size;
+    };
+    // Gives the requests taken from the idle pool back when the batch is done or
+    // an image or the results fetcher throws, running ones once they finished.
+    struct HeldRequests {
+        const CnnDLSDKBase* owner;
+        std::deque<Chunk> in_flight;
+        InferRequest::Ptr pending;
+
+        ~HeldRequests() {
+            if (pending) {
+                owner->ReleaseRequest(pending);
+            }
+            for (const auto& chunk : in_flight) {
+                try {
+                    chunk.request->Wait(IInferRequest::WaitMode::RESULT_READY);
+                } catch (...) {
+                    // the request is idle again either way
+                }
+                owner->ReleaseRequest(chunk.request);
+            }
+        }
+    } held{this, {}, nullptr};
+    // the oldest request stays held until its results have been fetched
+    auto finish_oldest = [&]() {
+        const Chunk& chunk = held.in_flight.front();
+        chunk.request->Wait(IInferRequest::WaitMode::RESULT_READY);
+
+        InferenceEngine::BlobMap blobs;
+        for (const auto& name : output_blobs_names_)  {
+            blobs[name] = chunk.request->GetBlob(name);
+        }
+        fetch_results(blobs, chunk.size);
+        InferRequest::Ptr request = chunk.request;
+        held.in_flight.pop_front();
+        return request;
+    };
 
     size_t num_imgs = frames.size();
-    for (size_t batch_i = 0; batch_i < num_imgs; batch_i += batch_size) {
+    for (size_t batch_i = 0; batch_i < num_imgs;) {
+        // Only wait for another caller's request while holding none, otherwise
+        // two callers could wait for each other. Reuse our oldest one instead.
+        held.pending = AcquireRequest(held.in_flight.empty());
+        if (!held.pending) {
+            held.pending = finish_oldest();
+        }
+        InferRequest::Ptr request = held.pending;
+
+        Blob::Ptr input = request->GetBlob(input_blob_name_);
+        const size_t batch_size = input->getTensorDesc().getDims()[0];
         const size_t current_batch_size = std::min(batch_size, num_imgs - batch_i);
         for (size_t b = 0; b < current_batch_size; b++) {
             matU8ToBlob<uint8_t>(frames[batch_i + b], input, b);
         }
 
-        infer_request_.SetBatch(current_batch_size);
-        infer_request_.Infer();
-
-        InferenceEngine::BlobMap blobs;
-	for (const auto& name : output_blobs_names_)  {	
-		blobs[name] = infer_request_.GetBlob(name);
-	}
-	fetch_results(blobs, current_batch_size);
+        request->SetBatch(current_batch_size);
+        request->StartAsync();
+        held.in_flight.push_back({request, current_batch_size});
+        held.pending = nullptr;
+        batch_i += current_batch_size;
+    }
+    while (!held.in_flight.empty()) {
+        ReleaseRequest(finish_oldest());
     }
 }
 
 
 void CnnDLSDKBase::PrintPerformanceCounts(std::string fullDeviceName) const {
-	if (!config_.enabled) {
+	if (!config_.enabled || infer_requests_.empty()) {
 		return;
 	}
-	std::cout << "Performance counts for " << config_.path_to_model << std::endl << std::endl;
-	::printPerformanceCounts(infer_request_, std::cout, fullDeviceName, false);
+	std::cout << "Performance counts for " << config_.path_to_model << ", summed over "
+	          << infer_requests_.size() << " infer requests" << std::endl << std::endl;
+	std::map<std::string, InferenceEngineProfileInfo> counts = SumPerformanceCounts(infer_requests_);
+	::printPerformanceCounts(counts, std::cout, fullDeviceName, false);
 }
 
 void CnnDLSDKBase::Infer(const cv::Mat& frame,
@@ -140,3 +289,57 @@ void VectorCNN::Compute(const std::vector<cv::Mat>& images, std::vector<cv::Mat>
     };
     InferBatch(images, results_fetcher);
 }
+
+VectorCNN::~VectorCNN() {
+    {
+        std::lock_guard<std::mutex> lock(async_mutex_);
+        async_stopped_ = true;
+    }
+    async_cv_.notify_all();
+    for (auto& worker : async_workers_) {
+        worker.join();
+    }
+}
+
+std::future<std::vector<cv::Mat>> VectorCNN::ComputeAsync(const std::vector<cv::Mat>& images,
+                                                          cv::Size outp_shape,
+                                                          std::function<void(std::vector<cv::Mat>*)> prepare) const {
+    std::packaged_task<std::vector<cv::Mat>()> task([this, images, outp_shape, prepare]() {
+        std::vector<cv::Mat> inputs = images;
+        if (prepare) {
+            prepare(&inputs);
+        }
+        std::vector<cv::Mat> vectors;
+        Compute(inputs, &vectors, outp_shape);
+        return vectors;
+    });
+    std::future<std::vector<cv::Mat>> vectors = task.get_future();
+    {
+        std::lock_guard<std::mutex> lock(async_mutex_);
+        // as many workers as calls can run on the infer requests at once
+        if (async_workers_.empty()) {
+            for (int i = 0; i < std::max(config_.num_requests, 1); i++) {
+                async_workers_.emplace_back(&VectorCNN::AsyncLoop, this);
+            }
+        }
+        async_tasks_.push_back(std::move(task));
+    }
+    async_cv_.notify_one();
+    return vectors;
+}
+
+void VectorCNN::AsyncLoop() const {
+    std::unique_lock<std::mutex> lock(async_mutex_);
+    while (true) {
+        async_cv_.wait(lock, [this] { return async_stopped_ || !async_tasks_.empty(); });
+        if (async_tasks_.empty()) {
+            return;
+        }
+        std::packaged_task<std::vector<cv::Mat>()> task = std::move(async_tasks_.front());
+        async_tasks_.pop_front();
+        lock.unlock();
+        // an exception ends up in the future of the call
+        task();
+        lock.lock();
+    }
+}
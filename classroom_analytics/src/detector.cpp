@@ -67,32 +67,19 @@ cv::Rect IncreaseRect(const cv::Rect& r, float coeff_x,
 
     return cv::Rect(new_tl_int, new_br_int);
 }
-}  // namespace
-
-void FaceDetection::submitRequest() {
-    if (!enqueued_frames_) return;
-    enqueued_frames_ = 0;
-    results_fetched_ = false;
-    results.clear();
-    BaseCnnDetection::submitRequest();
-}
-
-void FaceDetection::enqueue(const cv::Mat &frame) {
-    if (!enabled()) return;
-
-    if (!request) {
-        request = net_.CreateInferRequestPtr();
-    }
-
-    width_ = frame.cols;
-    height_ = frame.rows;
-
-    Blob::Ptr inputBlob = request->GetBlob(input_name_);
-
-    matU8ToBlob<uint8_t>(frame, inputBlob);
 
-    enqueued_frames_ = 1;
-}
+// Infer request of a BaseDetection held for one Compute() call, returned on any exit
+class HeldRequest {
+public:
+    explicit HeldRequest(BaseDetection& detector) : detector_(detector), request_(detector.acquireRequest()) {}
+    ~HeldRequest() { detector_.releaseRequest(request_); }
+    InferRequest& operator*() const { return *request_; }
+
+private:
+    BaseDetection& detector_;
+    InferRequest::Ptr request_;
+};
+}  // namespace
 
 FaceDetection::FaceDetection(const DetectorConfig& config) :
     BaseCnnDetection(config.enabled, config.is_async), config_(config) {
@@ -152,16 +139,51 @@ FaceDetection::FaceDetection(const DetectorConfig& config) :
         _output->setLayout(TensorDesc::getLayoutByDims(_output->getDims()));
 
         input_name_ = inputInfo.begin()->first;
-        net_ = config_.plugin.LoadNetwork(net_reader.getNetwork(), config_.device,{});
+        net_ = config_.plugin.LoadNetwork(net_reader.getNetwork(), config_.device,
+                                          ThroughputConfig(config_.device, NumStreams(config_)));
     }
 }
 
-void FaceDetection::fetchResults() {
+FaceDetection::FaceDetection(const FaceDetection& other) :
+    BaseCnnDetection(other), config_(other.config_), net_(other.net_),
+    input_name_(other.input_name_), output_name_(other.output_name_),
+    max_detections_count_(other.max_detections_count_), object_size_(other.object_size_) {
+    // the pool of infer requests is created on the first SubmitFrame()
+    request.reset();
+}
+
+void FaceDetection::SubmitFrame(const cv::Mat &frame, size_t frame_id) {
     if (!enabled()) return;
-    results.clear();
-    if (results_fetched_) return;
-    results_fetched_ = true;
-    const float *data = request->GetBlob(output_name_)->buffer().as<float *>();
+
+    if (!pool_.Created()) {
+        pool_.Create(net_, config_.num_requests);
+        if (!request) {
+            // performance counts are reported for the first request of the pool
+            request = pool_.Free();
+        }
+    }
+
+    Blob::Ptr inputBlob = pool_.Free()->GetBlob(input_name_);
+
+    matU8ToBlob<uint8_t>(frame, inputBlob);
+
+    pool_.Start(frame_id, frame.size());
+}
+
+size_t FaceDetection::FetchOldest(DetectedObjects* detections) {
+    const InFlightRequest& oldest = pool_.WaitOldest();
+    detections->clear();
+    ParseDetections(*oldest.request, oldest.frame_size, detections);
+    const size_t frame_id = oldest.frame_id;
+    pool_.Release();
+    return frame_id;
+}
+
+void FaceDetection::ParseDetections(InferRequest& request, const cv::Size& frame_size,
+                                    DetectedObjects* detections) const {
+    const float width = frame_size.width;
+    const float height = frame_size.height;
+    const float *data = request.GetBlob(output_name_)->buffer().as<float *>();
 
     for (int det_id = 0; det_id < max_detections_count_; ++det_id) {
         const int start_pos = det_id * object_size_;
@@ -173,13 +195,13 @@ void FaceDetection::fetchResults() {
 
         const float score = std::min(std::max(0.0f, data[start_pos + 2]), 1.0f);
         const float x0 =
-                std::min(std::max(0.0f, data[start_pos + 3]), 1.0f) * width_;
+                std::min(std::max(0.0f, data[start_pos + 3]), 1.0f) * width;
         const float y0 =
-                std::min(std::max(0.0f, data[start_pos + 4]), 1.0f) * height_;
+                std::min(std::max(0.0f, data[start_pos + 4]), 1.0f) * height;
         const float x1 =
-                std::min(std::max(0.0f, data[start_pos + 5]), 1.0f) * width_;
+                std::min(std::max(0.0f, data[start_pos + 5]), 1.0f) * width;
         const float y1 =
-                std::min(std::max(0.0f, data[start_pos + 6]), 1.0f) * height_;
+                std::min(std::max(0.0f, data[start_pos + 6]), 1.0f) * height;
 
         DetectedObject object;
         object.confidence = score;
@@ -189,10 +211,10 @@ void FaceDetection::fetchResults() {
         object.rect = TruncateToValidRect(IncreaseRect(object.rect,
                                                        config_.increase_scale_x,
                                                        config_.increase_scale_y),
-                                          cv::Size(width_, height_));
+                                          frame_size);
 
         if (object.confidence > config_.confidence_threshold && object.rect.area() > 0) {
-            results.emplace_back(object);
+            detections->emplace_back(object);
         }
     }
 }
@@ -205,7 +227,10 @@ BaseDetection::BaseDetection(std::string topoName,
                              bool doRawOutputMessages)
     : plugin(nullptr), topoName(topoName), pathToModel(pathToModel), deviceForInference(deviceForInference),
       maxBatch(maxBatch), isBatchDynamic(isBatchDynamic), isAsync(isAsync),
-      enablingChecked(false), _enabled(false), doRawOutputMessages(doRawOutputMessages) {
+      _enabled(!pathToModel.empty()), doRawOutputMessages(doRawOutputMessages) {
+    if (!_enabled) {
+        slog::info << topoName << " DISABLED" << slog::endl;
+    }
     if (isAsync) {
         slog::info << "Use async mode for " << topoName << slog::endl;
     }
@@ -217,29 +242,43 @@ ExecutableNetwork* BaseDetection::operator ->() {
     return &net;
 }
 
-void BaseDetection::submitRequest() {
-    if (!enabled() || request == nullptr) return;
-    if (isAsync) {
-        request->StartAsync();
-    } else {
-        request->Infer();
+void BaseDetection::createRequests(int count) {
+    std::lock_guard<std::mutex> lock(idleMutex);
+    for (int i = 0; i < std::max(count, 1); i++) {
+        requests.push_back(net.CreateInferRequestPtr());
     }
+    idleRequests = requests;
 }
 
-void BaseDetection::wait() {
-    if (!enabled()|| !request || !isAsync)
-        return;
-    request->Wait(IInferRequest::WaitMode::RESULT_READY);
+InferRequest::Ptr BaseDetection::acquireRequest() {
+    std::unique_lock<std::mutex> lock(idleMutex);
+    idleCv.wait(lock, [this] { return !idleRequests.empty(); });
+    InferRequest::Ptr request = idleRequests.back();
+    idleRequests.pop_back();
+    return request;
 }
 
-bool BaseDetection::enabled() const  {
-    if (!enablingChecked) {
-        _enabled = !pathToModel.empty();
-        if (!_enabled) {
-            slog::info << topoName << " DISABLED" << slog::endl;
-        }
-        enablingChecked = true;
+void BaseDetection::releaseRequest(const InferRequest::Ptr& request) {
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        idleRequests.push_back(request);
+    }
+    idleCv.notify_one();
+}
+
+void BaseDetection::submitRequest(InferRequest& request, size_t numFaces) {
+    if (isBatchDynamic) {
+        request.SetBatch(numFaces);
     }
+    if (isAsync) {
+        request.StartAsync();
+        request.Wait(IInferRequest::WaitMode::RESULT_READY);
+    } else {
+        request.Infer();
+    }
+}
+
+bool BaseDetection::enabled() const  {
     return _enabled;
 }
 
@@ -247,41 +286,19 @@ HeadPoseDetection::HeadPoseDetection(const std::string &pathToModel,
                                      const std::string &deviceForInference,
                                      int maxBatch, bool isBatchDynamic, bool isAsync, bool doRawOutputMessages)
     : BaseDetection("Head Pose", pathToModel, deviceForInference, maxBatch, isBatchDynamic, isAsync, doRawOutputMessages),
-      outputAngleR("angle_r_fc"), outputAngleP("angle_p_fc"), outputAngleY("angle_y_fc"), enquedFaces(0) {
-}
-
-void HeadPoseDetection::submitRequest()  {
-    if (!enquedFaces) return;
-    if (isBatchDynamic) {
-        request->SetBatch(enquedFaces);
-    }
-    BaseDetection::submitRequest();
-    enquedFaces = 0;
+      outputAngleR("angle_r_fc"), outputAngleP("angle_p_fc"), outputAngleY("angle_y_fc") {
 }
 
-void HeadPoseDetection::enqueue(const cv::Mat &face) {
-    if (!enabled()) {
-        return;
-    }
-    if (enquedFaces == maxBatch) {
-        slog::warn << "Number of detected faces more than maximum(" << maxBatch << ") processed by Head Pose estimator" << slog::endl;
-        return;
-    }
-    if (!request) {
-        request = net.CreateInferRequestPtr();
-    }
-
-    Blob::Ptr inputBlob = request->GetBlob(input);
-
-    matU8ToBlob<uint8_t>(face, inputBlob, enquedFaces);
+void HeadPoseDetection::enqueue(InferRequest &request, const cv::Mat &face, size_t idx) {
+    Blob::Ptr inputBlob = request.GetBlob(input);
 
-    enquedFaces++;
+    matU8ToBlob<uint8_t>(face, inputBlob, idx);
 }
 
-HeadPoseDetection::Results HeadPoseDetection::operator[] (int idx) const {
-    Blob::Ptr  angleR = request->GetBlob(outputAngleR);
-    Blob::Ptr  angleP = request->GetBlob(outputAngleP);
-    Blob::Ptr  angleY = request->GetBlob(outputAngleY);
+HeadPoseDetection::Results HeadPoseDetection::fetch(InferRequest &request, int idx) const {
+    Blob::Ptr  angleR = request.GetBlob(outputAngleR);
+    Blob::Ptr  angleP = request.GetBlob(outputAngleP);
+    Blob::Ptr  angleY = request.GetBlob(outputAngleY);
 
     HeadPoseDetection::Results r = {angleR->buffer().as<float*>()[idx],
                                     angleP->buffer().as<float*>()[idx],
@@ -296,6 +313,25 @@ HeadPoseDetection::Results HeadPoseDetection::operator[] (int idx) const {
     return r;
 }
 
+void HeadPoseDetection::Compute(const std::vector<cv::Mat> &faces, std::vector<Results> *results) {
+    results->clear();
+    if (!enabled() || faces.empty()) {
+        return;
+    }
+    // every caller holds its own request, classrooms only wait for each other if all are taken
+    HeldRequest request(*this);
+    for (size_t begin = 0; begin < faces.size(); begin += maxBatch) {
+        const size_t end = std::min(faces.size(), begin + maxBatch);
+        for (size_t i = begin; i < end; i++) {
+            enqueue(*request, faces[i], i - begin);
+        }
+        submitRequest(*request, end - begin);
+        for (size_t i = 0; i < end - begin; i++) {
+            results->push_back(fetch(*request, i));
+        }
+    }
+}
+
 CNNNetwork HeadPoseDetection::read() {
     slog::info << "Loading network files for Head Pose Estimation network" << slog::endl;
     CNNNetReader netReader;
@@ -359,51 +395,25 @@ CNNNetwork HeadPoseDetection::read() {
 
     slog::info << "Loading Head Pose Estimation model to the "<< deviceForInference << " plugin" << slog::endl;
 
-    _enabled = true;
     return netReader.getNetwork();
 }
 
 EmotionsDetection::EmotionsDetection(const std::string &pathToModel,
                                      const std::string &deviceForInference,
                                      int maxBatch, bool isBatchDynamic, bool isAsync, bool doRawOutputMessages)
-              : BaseDetection("Emotions Recognition", pathToModel, deviceForInference, maxBatch, isBatchDynamic, isAsync, doRawOutputMessages),
-                enquedFaces(0) {
+              : BaseDetection("Emotions Recognition", pathToModel, deviceForInference, maxBatch, isBatchDynamic, isAsync, doRawOutputMessages) {
 }
 
-void EmotionsDetection::submitRequest() {
-    if (!enquedFaces) return;
-    if (isBatchDynamic) {
-        request->SetBatch(enquedFaces);
-    }
-    BaseDetection::submitRequest();
-    enquedFaces = 0;
-}
-
-void EmotionsDetection::enqueue(const cv::Mat &face) {
-    if (!enabled()) {
-        return;
-    }
-    if (enquedFaces == maxBatch) {
-        slog::warn << "Number of detected faces more than maximum(" << maxBatch << ") processed by Emotions Recognition network" << slog::endl;
-        return;
-    }
-    if (!request) {
-        request = net.CreateInferRequestPtr();
-    }
-
-    Blob::Ptr inputBlob = request->GetBlob(input);
+void EmotionsDetection::enqueue(InferRequest &request, const cv::Mat &face, size_t idx) {
+    Blob::Ptr inputBlob = request.GetBlob(input);
 
-    matU8ToBlob<uint8_t>(face, inputBlob, enquedFaces);
-
-    enquedFaces++;
+    matU8ToBlob<uint8_t>(face, inputBlob, idx);
 }
 
-std::map<std::string, float> EmotionsDetection::operator[] (int idx) const {
-    // Vector of supported emotions
-    static const std::vector<std::string> emotionsVec = {"neutral", "happy", "sad", "surprise", "anger"};
+EmotionsDetection::Results EmotionsDetection::fetch(InferRequest &request, int idx) const {
     auto emotionsVecSize = emotionsVec.size();
 
-    Blob::Ptr emotionsBlob = request->GetBlob(outputEmotions);
+    Blob::Ptr emotionsBlob = request.GetBlob(outputEmotions);
 
     /* emotions vector must have the same size as number of channels
      * in model output. Default output format is NCHW, so index 1 is checked */
@@ -417,14 +427,14 @@ std::map<std::string, float> EmotionsDetection::operator[] (int idx) const {
 
     auto emotionsValues = emotionsBlob->buffer().as<float *>();
     auto outputIdxPos = emotionsValues + idx * emotionsVecSize;
-    std::map<std::string, float> emotions;
+    Results emotions;
 
     if (doRawOutputMessages) {
         std::cout << "[" << idx << "] element, predicted emotions (name = prob):" << std::endl;
     }
 
     for (size_t i = 0; i < emotionsVecSize; i++) {
-        emotions[emotionsVec[i]] = outputIdxPos[i];
+        emotions[i] = outputIdxPos[i];
 
         if (doRawOutputMessages) {
             std::cout << emotionsVec[i] << " = " << outputIdxPos[i];
@@ -438,6 +448,26 @@ std::map<std::string, float> EmotionsDetection::operator[] (int idx) const {
 
     return emotions;
 }
+
+void EmotionsDetection::Compute(const std::vector<cv::Mat> &faces, std::vector<Results> *results) {
+    results->clear();
+    if (!enabled() || faces.empty()) {
+        return;
+    }
+    // every caller holds its own request, classrooms only wait for each other if all are taken
+    HeldRequest request(*this);
+    for (size_t begin = 0; begin < faces.size(); begin += maxBatch) {
+        const size_t end = std::min(faces.size(), begin + maxBatch);
+        for (size_t i = begin; i < end; i++) {
+            enqueue(*request, faces[i], i - begin);
+        }
+        submitRequest(*request, end - begin);
+        for (size_t i = 0; i < end - begin; i++) {
+            results->push_back(fetch(*request, i));
+        }
+    }
+}
+
 CNNNetwork EmotionsDetection::read() {
     slog::info << "Loading network files for Emotions Recognition" << slog::endl;
     InferenceEngine::CNNNetReader netReader;
@@ -500,20 +530,23 @@ CNNNetwork EmotionsDetection::read() {
     outputEmotions = emotionsOutput->getName();
 
     slog::info << "Loading Emotions Recognition model to the "<< deviceForInference << " plugin" << slog::endl;
-    _enabled = true;
     return netReader.getNetwork();
 }
 
 Load::Load(BaseDetection& detector) : detector(detector) {
 }
 
-void Load::into(Core & plg, std::string device, bool enable_dynamic_batch) const {
+void Load::into(Core & plg, std::string device, bool enable_dynamic_batch, int num_requests) const {
     if (detector.enabled()) {
-        std::map<std::string, std::string> config;
+        std::map<std::string, std::string> config = ThroughputConfig(device, num_requests);
+        if (enable_dynamic_batch) {
+            config[PluginConfigParams::KEY_DYN_BATCH_ENABLED] = PluginConfigParams::YES;
+        }
 
 	    detector.net = plg.LoadNetwork(detector.read(), device, config);
 	if(static_cast<IExecutableNetwork::Ptr> (detector.net).get() == nullptr)
                 slog::info << "Null pointer detected" << slog::endl;
         detector.plugin = &plg;
+        detector.createRequests(num_requests);
     }
 }
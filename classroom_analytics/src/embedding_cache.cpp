@@ -0,0 +1,233 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "embedding_cache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <samples/slog.hpp>
+
+namespace {
+
+const char magic[8] = {'C', 'A', 'E', 'M', 'B', '0', '0', '1'};
+
+struct Header {
+    char magic[8];
+    uint64_t model;
+    uint32_t dim;
+    uint32_t reserved;
+    uint64_t count;
+};
+
+size_t EntrySize(size_t dim) {
+    return sizeof(uint64_t) + dim * sizeof(float);
+}
+
+uint64_t EntryKey(const char* entry) {
+    uint64_t key;
+    std::memcpy(&key, entry, sizeof(key));
+    return key;
+}
+
+}  // anonymous namespace
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t HashFiles(const std::vector<std::string>& paths, const std::vector<std::string>& strings) {
+    uint64_t hash = HashBytes(nullptr, 0);
+    std::vector<char> buffer(1 << 16);
+    for (const auto& path : paths) {
+        hash = HashBytes(path.data(), path.size() + 1, hash);
+        std::ifstream in(path, std::ios::binary);
+        while (in) {
+            in.read(buffer.data(), buffer.size());
+            hash = HashBytes(buffer.data(), static_cast<size_t>(in.gcount()), hash);
+        }
+    }
+    for (const auto& text : strings) {
+        hash = HashBytes(text.data(), text.size() + 1, hash);
+    }
+    return hash;
+}
+
+EmbeddingCache::EmbeddingCache(const std::string& path, uint64_t model)
+    : path_(path), model_(model), data_(nullptr), data_size_(0), dim_(0), count_(0) {
+    Map();
+}
+
+EmbeddingCache::~EmbeddingCache() {
+    Unmap();
+}
+
+void EmbeddingCache::Map() {
+    int fd = open(path_.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        close(fd);
+        return;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        slog::warn << "Cannot map the embedding cache " << path_ << slog::endl;
+        return;
+    }
+    data_ = static_cast<const char*>(data);
+    data_size_ = static_cast<size_t>(info.st_size);
+
+    Header header;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.dim == 0 ||
+        data_size_ != sizeof(Header) + header.count * EntrySize(header.dim)) {
+        slog::warn << "Ignoring the malformed embedding cache " << path_ << slog::endl;
+        Unmap();
+        return;
+    }
+    if (header.model != model_) {
+        slog::info << "The embedding cache " << path_ << " was computed by other models, rebuilding it" << slog::endl;
+        Unmap();
+        return;
+    }
+    dim_ = header.dim;
+    count_ = static_cast<size_t>(header.count);
+}
+
+void EmbeddingCache::Unmap() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), data_size_);
+    }
+    data_ = nullptr;
+    data_size_ = 0;
+    count_ = 0;
+}
+
+const char* EmbeddingCache::Entry(size_t index) const {
+    return data_ + sizeof(Header) + index * EntrySize(dim_);
+}
+
+void EmbeddingCache::BeginBuild() {
+    used_.clear();
+}
+
+bool EmbeddingCache::Find(uint64_t key, cv::Mat* embedding) {
+    auto added = added_.find(key);
+    if (added != added_.end()) {
+        added->second.copyTo(*embedding);
+        used_.insert(key);
+        return true;
+    }
+    size_t lo = 0;
+    size_t hi = count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (EntryKey(Entry(mid)) < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == count_ || EntryKey(Entry(lo)) != key) {
+        return false;
+    }
+    embedding->create(static_cast<int>(dim_), 1, CV_32F);
+    std::memcpy(embedding->data, Entry(lo) + sizeof(uint64_t), dim_ * sizeof(float));
+    used_.insert(key);
+    return true;
+}
+
+void EmbeddingCache::Add(uint64_t key, const cv::Mat& embedding) {
+    CV_Assert(embedding.type() == CV_32F && embedding.isContinuous());
+    const size_t dim = embedding.total();
+    if (dim_ != dim) {
+        // a new model output size invalidates whatever was mapped
+        Unmap();
+        used_.clear();
+        added_.clear();
+        dim_ = dim;
+    }
+    added_[key] = embedding.reshape(1, static_cast<int>(dim)).clone();
+    used_.insert(key);
+}
+
+bool EmbeddingCache::Changed() const {
+    // added entries that were not saved yet, only those of the current build are written
+    size_t used_added = 0;
+    for (const auto& item : added_) {
+        used_added += used_.count(item.first);
+    }
+    return used_added > 0 || used_.size() != count_;
+}
+
+bool EmbeddingCache::Save() {
+    std::vector<std::pair<uint64_t, const char*>> entries;
+    entries.reserve(used_.size() + added_.size());
+    for (size_t i = 0; i < count_; i++) {
+        uint64_t key = EntryKey(Entry(i));
+        if (used_.count(key) && !added_.count(key)) {
+            entries.emplace_back(key, Entry(i) + sizeof(uint64_t));
+        }
+    }
+    for (const auto& item : added_) {
+        if (used_.count(item.first)) {
+            entries.emplace_back(item.first, reinterpret_cast<const char*>(item.second.ptr<float>()));
+        }
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const std::pair<uint64_t, const char*>& a, const std::pair<uint64_t, const char*>& b) {
+                  return a.first < b.first;
+              });
+
+    Header header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.model = model_;
+    header.dim = static_cast<uint32_t>(dim_);
+    header.reserved = 0;
+    header.count = entries.size();
+
+    const std::string temp_path = path_ + ".tmp";
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        slog::warn << "Cannot write the embedding cache " << path_ << slog::endl;
+        return false;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    for (const auto& entry : entries) {
+        written = written && std::fwrite(&entry.first, sizeof(entry.first), 1, file) == 1 &&
+                  std::fwrite(entry.second, sizeof(float), dim_, file) == dim_;
+    }
+    written = std::fclose(file) == 0 && written;
+    if (!written || std::rename(temp_path.c_str(), path_.c_str()) != 0) {
+        slog::warn << "Cannot write the embedding cache " << path_ << slog::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    added_.clear();
+    Unmap();
+    Map();
+    return true;
+}
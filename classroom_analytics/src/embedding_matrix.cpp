@@ -0,0 +1,133 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "embedding_matrix.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace {
+
+// Quantized rows converted back to float at once, about 1 MB of floats with 256-d embeddings
+const int convert_block_rows = 1024;
+
+}  // anonymous namespace
+
+bool ParseEmbeddingPrecision(const std::string& text, EmbeddingPrecision* precision) {
+    if (text == "fp32") {
+        *precision = EmbeddingPrecision::FP32;
+    } else if (text == "fp16") {
+        *precision = EmbeddingPrecision::FP16;
+    } else if (text == "int8") {
+        *precision = EmbeddingPrecision::INT8;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* EmbeddingPrecisionName(EmbeddingPrecision precision) {
+    switch (precision) {
+    case EmbeddingPrecision::FP16:
+        return "fp16";
+    case EmbeddingPrecision::INT8:
+        return "int8";
+    default:
+        return "fp32";
+    }
+}
+
+EmbeddingMatrix::EmbeddingMatrix(const cv::Mat& rows, EmbeddingPrecision precision)
+    : precision_(precision), rows_(rows.rows), cols_(rows.cols) {
+    CV_Assert(rows.type() == CV_32F);
+    switch (precision_) {
+    case EmbeddingPrecision::FP32:
+        fp32_ = rows.clone();
+        break;
+    case EmbeddingPrecision::FP16:
+        cv::convertFp16(rows, fp16_);
+        break;
+    case EmbeddingPrecision::INT8:
+        int8_.create(rows_, cols_, CV_8S);
+        scales_.resize(rows_);
+        for (int r = 0; r < rows_; r++) {
+            const float* row = rows.ptr<float>(r);
+            int8_t* quantized = int8_.ptr<int8_t>(r);
+            float max_abs = 0.0f;
+            for (int c = 0; c < cols_; c++) {
+                max_abs = std::max(max_abs, std::fabs(row[c]));
+            }
+            scales_[r] = max_abs > 0.0f ? max_abs / 127.0f : 1.0f;
+            for (int c = 0; c < cols_; c++) {
+                int value = static_cast<int>(std::lround(row[c] / scales_[r]));
+                quantized[c] = static_cast<int8_t>(std::max(-127, std::min(127, value)));
+            }
+        }
+        break;
+    }
+}
+
+size_t EmbeddingMatrix::ByteSize() const {
+    return fp32_.total() * sizeof(float) + fp16_.total() * sizeof(uint16_t) +
+           int8_.total() * sizeof(int8_t) + scales_.size() * sizeof(float);
+}
+
+void EmbeddingMatrix::Similarities(const cv::Mat& queries, cv::Mat* similarities) const {
+    CV_Assert(queries.type() == CV_32F && queries.cols == cols_);
+    if (precision_ == EmbeddingPrecision::FP32) {
+        cv::gemm(queries, fp32_, 1.0, cv::noArray(), 0.0, *similarities, cv::GEMM_2_T);
+        return;
+    }
+    // blocks of rows go back to float through OpenCV's vectorized conversions and take the same GEMM
+    similarities->create(queries.rows, rows_, CV_32F);
+    cv::Mat block, block_similarities;
+    for (int begin = 0; begin < rows_; begin += convert_block_rows) {
+        const int end = std::min(rows_, begin + convert_block_rows);
+        if (precision_ == EmbeddingPrecision::FP16) {
+            cv::convertFp16(fp16_.rowRange(begin, end), block);
+        } else {
+            int8_.rowRange(begin, end).convertTo(block, CV_32F);
+        }
+        cv::gemm(queries, block, 1.0, cv::noArray(), 0.0, block_similarities, cv::GEMM_2_T);
+        for (int q = 0; q < queries.rows; q++) {
+            const float* in = block_similarities.ptr<float>(q);
+            float* out = similarities->ptr<float>(q) + begin;
+            for (int r = 0; r < end - begin; r++) {
+                out[r] = precision_ == EmbeddingPrecision::INT8 ? in[r] * scales_[begin + r] : in[r];
+            }
+        }
+    }
+}
+
+double NearestNeighbourRecall(const cv::Mat& rows, const EmbeddingMatrix& quantized, int max_queries) {
+    if (rows.rows < 2) {
+        return 1.0;
+    }
+    const int num_queries = std::min(rows.rows, max_queries);
+    cv::Mat queries(num_queries, rows.cols, CV_32F);
+    std::vector<int> query_rows(num_queries);
+    for (int i = 0; i < num_queries; i++) {
+        query_rows[i] = static_cast<int>(static_cast<int64_t>(i) * rows.rows / num_queries);
+        rows.row(query_rows[i]).copyTo(queries.row(i));
+    }
+    cv::Mat exact, approximate;
+    cv::gemm(queries, rows, 1.0, cv::noArray(), 0.0, exact, cv::GEMM_2_T);
+    quantized.Similarities(queries, &approximate);
+
+    int same = 0;
+    for (int i = 0; i < num_queries; i++) {
+        // the query itself is left out
+        exact.at<float>(i, query_rows[i]) = -2.0f;
+        approximate.at<float>(i, query_rows[i]) = -2.0f;
+        cv::Point exact_best, approximate_best;
+        cv::minMaxLoc(exact.row(i), nullptr, nullptr, nullptr, &exact_best);
+        cv::minMaxLoc(approximate.row(i), nullptr, nullptr, nullptr, &approximate_best);
+        same += exact_best.x == approximate_best.x;
+    }
+    return static_cast<double>(same) / num_queries;
+}
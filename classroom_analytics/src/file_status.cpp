@@ -0,0 +1,24 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "file_status.hpp"
+
+#include <string>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+bool ReadFileStatus(const std::string& path, FileStatus* status) {
+    *status = FileStatus();
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    const long long ns_per_s = 1000000000LL;
+    status->mtime_ns = static_cast<long long>(info.st_mtim.tv_sec) * ns_per_s + info.st_mtim.tv_nsec;
+    status->ctime_ns = static_cast<long long>(info.st_ctim.tv_sec) * ns_per_s + info.st_ctim.tv_nsec;
+    status->inode = static_cast<long long>(info.st_ino);
+    status->size = static_cast<long long>(info.st_size);
+    return true;
+}
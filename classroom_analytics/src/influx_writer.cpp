@@ -0,0 +1,507 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "influx_writer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <samples/slog.hpp>
+
+namespace {
+
+std::string Escape(const std::string& value, const char* special) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\n' || c == '\r') {
+            c = ' ';
+        }
+        if (c != '\0' && std::strchr(special, c)) {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+std::string UrlEncode(const std::string& value) {
+    std::ostringstream encoded;
+    encoded << std::hex << std::uppercase;
+    for (unsigned char c : value) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            encoded << c;
+        } else {
+            encoded << '%' << std::setw(2) << std::setfill('0') << static_cast<int>(c);
+        }
+    }
+    return encoded.str();
+}
+
+std::string ToLower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+}  // anonymous namespace
+
+LinePoint::LinePoint(const std::string& measurement) : key_(Escape(measurement, ", ")) {}
+
+LinePoint& LinePoint::Tag(const std::string& key, const std::string& value) {
+    if (!value.empty()) {
+        key_ += ',' + Escape(key, ",= ") + '=' + Escape(value, ",= ");
+    }
+    return *this;
+}
+
+LinePoint& LinePoint::Field(const std::string& key, double value) {
+    if (std::isfinite(value)) {
+        std::ostringstream formatted;
+        formatted << std::setprecision(std::numeric_limits<double>::digits10) << value;
+        fields_ += (fields_.empty() ? "" : ",") + Escape(key, ",= ") + '=' + formatted.str();
+    }
+    return *this;
+}
+
+LinePoint& LinePoint::Field(const std::string& key, const std::string& value) {
+    fields_ += (fields_.empty() ? "" : ",") + Escape(key, ",= ") + "=\"" + Escape(value, "\"\\") + '"';
+    return *this;
+}
+
+LinePoint& LinePoint::Time(std::chrono::system_clock::time_point time) {
+    time_ = std::to_string(
+        std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count());
+    return *this;
+}
+
+std::string LinePoint::Line() const {
+    if (fields_.empty()) {
+        return std::string();
+    }
+    std::string line = key_ + ' ' + fields_;
+    if (!time_.empty()) {
+        line += ' ' + time_;
+    }
+    return line;
+}
+
+HttpConnection::HttpConnection(const std::string& host, int port, std::chrono::milliseconds timeout)
+    : host_(host), port_(port), timeout_(timeout), fd_(-1) {}
+
+HttpConnection::~HttpConnection() {
+    Close();
+}
+
+void HttpConnection::Close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    buffer_.clear();
+}
+
+bool HttpConnection::Connect() {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host_.c_str(), std::to_string(port_).c_str(), &hints, &addresses) != 0) {
+        return false;
+    }
+    timeval tv;
+    tv.tv_sec = static_cast<time_t>(timeout_.count() / 1000);
+    tv.tv_usec = static_cast<suseconds_t>((timeout_.count() % 1000) * 1000);
+    for (addrinfo* address = addresses; address != nullptr; address = address->ai_next) {
+        int fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+            fd_ = fd;
+            break;
+        }
+        ::close(fd);
+    }
+    freeaddrinfo(addresses);
+    buffer_.clear();
+    return fd_ >= 0;
+}
+
+bool HttpConnection::SendAll(const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool HttpConnection::Fill() {
+    char chunk[4096];
+    ssize_t n = ::recv(fd_, chunk, sizeof(chunk), 0);
+    if (n <= 0) {
+        return false;
+    }
+    buffer_.append(chunk, static_cast<size_t>(n));
+    return true;
+}
+
+bool HttpConnection::ReadLine(std::string* line) {
+    size_t end;
+    while ((end = buffer_.find("\r\n")) == std::string::npos) {
+        if (!Fill()) {
+            return false;
+        }
+    }
+    line->assign(buffer_, 0, end);
+    buffer_.erase(0, end + 2);
+    return true;
+}
+
+bool HttpConnection::ReadBytes(size_t count, std::string* data) {
+    while (buffer_.size() < count) {
+        if (!Fill()) {
+            return false;
+        }
+    }
+    if (data) {
+        data->append(buffer_, 0, count);
+    }
+    buffer_.erase(0, count);
+    return true;
+}
+
+int HttpConnection::Post(const std::string& target, const std::string& content_type,
+                         const std::string& body, std::string* response_body) {
+    std::ostringstream request;
+    request << "POST " << target << " HTTP/1.1\r\n"
+            << "Host: " << host_ << ':' << port_ << "\r\n"
+            << "Content-Type: " << content_type << "\r\n"
+            << "Content-Length: " << body.size() << "\r\n"
+            << "Connection: keep-alive\r\n\r\n"
+            << body;
+
+    // a kept-alive connection may have been closed by the server meanwhile, so it gets one retry
+    std::string status_line;
+    for (int attempt = 0; ; ++attempt) {
+        bool reused = fd_ >= 0;
+        if (!reused && !Connect()) {
+            return -1;
+        }
+        if (SendAll(request.str()) && ReadLine(&status_line)) {
+            break;
+        }
+        Close();
+        if (!reused || attempt > 0) {
+            return -1;
+        }
+    }
+
+    int status = -1;
+    std::istringstream status_stream(status_line);
+    std::string version;
+    status_stream >> version >> status;
+    if (version.compare(0, 5, "HTTP/") != 0 || status < 100) {
+        Close();
+        return -1;
+    }
+
+    bool chunked = false;
+    bool keep_alive = version != "HTTP/1.0";
+    long long content_length = -1;
+    std::string header;
+    while (true) {
+        if (!ReadLine(&header)) {
+            Close();
+            return -1;
+        }
+        if (header.empty()) {
+            break;
+        }
+        size_t colon = header.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string name = ToLower(header.substr(0, colon));
+        size_t value_start = header.find_first_not_of(' ', colon + 1);
+        std::string value = value_start == std::string::npos ? std::string() : ToLower(header.substr(value_start));
+        if (name == "content-length") {
+            content_length = std::atoll(value.c_str());
+        } else if (name == "transfer-encoding") {
+            chunked = value.find("chunked") != std::string::npos;
+        } else if (name == "connection") {
+            keep_alive = value.find("close") == std::string::npos;
+        }
+    }
+
+    bool complete = true;
+    bool has_body = status >= 200 && status != 204 && status != 304;
+    if (!has_body) {
+        content_length = 0;
+    } else if (chunked) {
+        std::string size_line;
+        while ((complete = ReadLine(&size_line))) {
+            size_t size = std::strtoul(size_line.c_str(), nullptr, 16);
+            if (size == 0) {
+                while ((complete = ReadLine(&size_line)) && !size_line.empty()) {}
+                break;
+            }
+            if (!(complete = ReadBytes(size, response_body) && ReadLine(&size_line))) {
+                break;
+            }
+        }
+    } else if (content_length >= 0) {
+        complete = ReadBytes(static_cast<size_t>(content_length), response_body);
+    } else {
+        // the body ends with the connection
+        while (Fill()) {}
+        if (response_body) {
+            response_body->append(buffer_);
+        }
+        keep_alive = false;
+    }
+    if (!complete || !keep_alive) {
+        Close();
+    }
+    return complete ? status : -1;
+}
+
+InfluxWriter::InfluxWriter(const InfluxConfig& config)
+    : config_(config), connection_(config.host, config.port, config.timeout),
+      closed_(false), failing_(false), database_ready_(false), replay_tokens_(0),
+      replay_refill_(std::chrono::steady_clock::now()), written_(0), dropped_(0), spooled_(0) {
+    if (!config_.spool_dir.empty()) {
+        spool_.reset(new LineSpool(config_.spool_dir, config_.spool_segment_bytes, config_.spool_max_segments));
+        if (!spool_->Open()) {
+            slog::warn << "Cannot open the metrics spool " << config_.spool_dir
+                       << ", points are kept in memory while InfluxDB is unavailable" << slog::endl;
+            spool_.reset();
+        } else if (!spool_->Empty()) {
+            slog::info << "Replaying the points spooled in " << config_.spool_dir << slog::endl;
+        }
+    }
+    flusher_ = std::thread(&InfluxWriter::FlushLoop, this);
+}
+
+InfluxWriter::~InfluxWriter() {
+    Close();
+}
+
+int InfluxWriter::QueryCreateDatabase(HttpConnection& connection, std::string* response) {
+    return connection.Post("/query", "application/x-www-form-urlencoded",
+                           "q=" + UrlEncode("CREATE DATABASE \"" + config_.database + "\""), response);
+}
+
+bool InfluxWriter::CreateDatabase() {
+    // the flush thread owns connection_
+    HttpConnection connection(config_.host, config_.port, config_.timeout);
+    std::string response;
+    int status = QueryCreateDatabase(connection, &response);
+    if (status != 200) {
+        slog::err << "InfluxDB at " << config_.host << ':' << config_.port << " answered " << status
+                  << " to CREATE DATABASE " << response << slog::endl;
+        return false;
+    }
+    database_ready_ = true;
+    return true;
+}
+
+void InfluxWriter::Write(const LinePoint& point) {
+    Write(point.Line());
+}
+
+void InfluxWriter::Write(std::string line) {
+    if (line.empty()) {
+        return;
+    }
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            ++dropped_;
+            return;
+        }
+        pending_.push_back(std::move(line));
+        if (pending_.size() > config_.max_pending) {
+            pending_.pop_front();
+            ++dropped_;
+        }
+        notify = pending_.size() >= config_.batch_size;
+    }
+    if (notify) {
+        cv_.notify_one();
+    }
+}
+
+void InfluxWriter::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    cv_.notify_one();
+    if (flusher_.joinable()) {
+        flusher_.join();
+        if (spool_ && !spool_->Empty()) {
+            slog::info << "Points left in the metrics spool " << config_.spool_dir
+                       << " are replayed by the next run" << slog::endl;
+        }
+    }
+}
+
+bool InfluxWriter::Send(const std::vector<std::string>& points, size_t begin, size_t end) {
+    const size_t num_points = end - begin;
+    std::string response;
+    int status = -1;
+    if (!database_ready_) {
+        database_ready_ = QueryCreateDatabase(connection_, &response) == 200;
+    }
+    if (database_ready_) {
+        std::string body;
+        for (size_t i = begin; i < end; i++) {
+            body += points[i];
+            body += '\n';
+        }
+        response.clear();
+        status = connection_.Post("/write?db=" + UrlEncode(config_.database) + "&precision=ms",
+                                  "text/plain; charset=utf-8", body, &response);
+    }
+    if (status == 404) {
+        // the server lost the database, it is created again on the next attempt
+        database_ready_ = false;
+    }
+    // malformed points would be rejected the same way on every retry
+    bool rejected = status >= 400 && status < 500 && status != 404;
+    if (status == 200 || status == 204 || rejected) {
+        if (rejected) {
+            slog::warn << "InfluxDB rejected " << num_points << " points: " << status << ' ' << response << slog::endl;
+            dropped_ += num_points;
+        } else {
+            written_ += num_points;
+        }
+        if (failing_) {
+            slog::info << "InfluxDB at " << config_.host << ':' << config_.port << " is reachable again" << slog::endl;
+        }
+        failing_ = false;
+        return true;
+    }
+    if (!failing_) {
+        slog::warn << "Cannot write to InfluxDB at " << config_.host << ':' << config_.port << ", "
+                   << (spool_ ? "spooling the points to " + config_.spool_dir : std::string("keeping the points in memory"))
+                   << slog::endl;
+    }
+    failing_ = true;
+    return false;
+}
+
+void InfluxWriter::Spill(std::vector<std::string>& points, size_t begin, bool closing) {
+    const size_t num_points = points.size() - begin;
+    if (spool_) {
+        size_t dropped_segments = spool_->DroppedSegments();
+        if (spool_->Append(points.begin() + begin, points.end())) {
+            spooled_ += num_points;
+        } else {
+            slog::warn << "Cannot write " << num_points << " points to the metrics spool " << config_.spool_dir << slog::endl;
+            dropped_ += num_points;
+        }
+        if (spool_->DroppedSegments() != dropped_segments) {
+            slog::warn << "The metrics spool " << config_.spool_dir << " is full, its oldest points are dropped" << slog::endl;
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closing) {
+        dropped_ += num_points;
+        return;
+    }
+    pending_.insert(pending_.begin(), std::make_move_iterator(points.begin() + begin),
+                    std::make_move_iterator(points.end()));
+    while (pending_.size() > config_.max_pending) {
+        pending_.pop_front();
+        ++dropped_;
+    }
+}
+
+void InfluxWriter::Replay(bool probe) {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - replay_refill_).count();
+    replay_refill_ = now;
+    // the bucket holds at most one second worth of points
+    replay_tokens_ = std::min<double>(config_.replay_rate, replay_tokens_ + elapsed * config_.replay_rate);
+
+    std::vector<std::string> lines;
+    while ((probe || !failing_) && replay_tokens_ >= 1) {
+        probe = false;
+        size_t max_lines = std::min(std::max<size_t>(config_.batch_size, 1), static_cast<size_t>(replay_tokens_));
+        if (!spool_->Read(max_lines, &lines) || !Send(lines, 0, lines.size())) {
+            break;
+        }
+        spool_->Commit();
+        replay_tokens_ -= lines.size();
+    }
+}
+
+void InfluxWriter::FlushLoop() {
+    const size_t batch_size = std::max<size_t>(config_.batch_size, 1);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // while the server is failing it is retried only once per interval
+        cv_.wait_for(lock, config_.flush_interval, [this] {
+            return closed_ || (!failing_ && pending_.size() >= config_.batch_size);
+        });
+        const bool closing = closed_;
+        std::vector<std::string> points(std::make_move_iterator(pending_.begin()),
+                                        std::make_move_iterator(pending_.end()));
+        pending_.clear();
+        lock.unlock();
+
+        // points that cannot be sent within one interval are spilled, a slow server must not hold back the next ones
+        auto deadline = std::chrono::steady_clock::now() + config_.flush_interval;
+        bool attempt = true;
+        size_t sent = 0;
+        while (sent < points.size() && (attempt || (!failing_ && std::chrono::steady_clock::now() < deadline))) {
+            attempt = false;
+            size_t end = std::min(points.size(), sent + batch_size);
+            if (!Send(points, sent, end)) {
+                break;
+            }
+            sent = end;
+        }
+        if (sent < points.size()) {
+            Spill(points, sent, closing);
+        }
+        if (spool_ && !closing) {
+            Replay(attempt);
+        }
+
+        lock.lock();
+        if (closing && pending_.empty()) {
+            break;
+        }
+    }
+}
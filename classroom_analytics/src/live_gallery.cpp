@@ -0,0 +1,108 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "live_gallery.hpp"
+
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <samples/slog.hpp>
+
+#include "file_status.hpp"
+
+namespace {
+
+// Mixes the status of a file into the hash, a missing file counts as well
+uint64_t HashFileStatus(const std::string& path, uint64_t hash) {
+    FileStatus status;
+    ReadFileStatus(path, &status);
+    const long long values[] = {status.mtime_ns, status.ctime_ns, status.inode, status.size};
+    return HashBytes(values, sizeof(values), hash);
+}
+
+}  // anonymous namespace
+
+LiveGallery::LiveGallery(const std::string& path, double threshold,
+                         const VectorCNN& landmarks_det, const VectorCNN& image_reid,
+                         EmbeddingCache* cache, const std::string& index_type,
+                         const std::string& precision, std::chrono::seconds check_interval)
+    : path_(path), threshold_(threshold), landmarks_det_(landmarks_det), image_reid_(image_reid),
+      cache_(cache), index_type_(index_type), precision_(precision), check_interval_(check_interval),
+      gallery_(std::make_shared<const EmbeddingsGallery>(path, threshold, landmarks_det, image_reid, cache,
+                                                         nullptr, index_type, precision)),
+      roster_(MakeRoster(*gallery_)), signature_(Signature(*gallery_)), stopped_(false) {
+    // without the models the gallery stays empty, there is nothing to watch
+    if (!path_.empty() && landmarks_det_.Enabled() && image_reid_.Enabled()) {
+        watcher_ = std::thread(&LiveGallery::WatchLoop, this);
+    }
+}
+
+LiveGallery::~LiveGallery() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    cv_.notify_all();
+    if (watcher_.joinable()) {
+        watcher_.join();
+    }
+}
+
+std::shared_ptr<const EmbeddingsGallery> LiveGallery::Current() const {
+    return std::atomic_load(&gallery_);
+}
+
+uint64_t LiveGallery::Signature(const EmbeddingsGallery& gallery) const {
+    uint64_t hash = HashFileStatus(path_, HashBytes(nullptr, 0));
+    for (const auto& image_path : gallery.GetImagePaths()) {
+        hash = HashFileStatus(image_path, hash);
+    }
+    return hash;
+}
+
+std::shared_ptr<const Roster> LiveGallery::MakeRoster(const EmbeddingsGallery& gallery) {
+    std::vector<bool> enrolled(gallery.size());
+    for (size_t id = 0; id < enrolled.size(); id++) {
+        enrolled[id] = gallery.IsEnrolled(static_cast<int>(id));
+    }
+    return std::make_shared<const Roster>(gallery.GetIDToLabelMap(), enrolled);
+}
+
+bool LiveGallery::Reload() {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    std::shared_ptr<const EmbeddingsGallery> current = Current();
+    const uint64_t signature = Signature(*current);
+    if (signature == signature_) {
+        return false;
+    }
+    signature_ = signature;
+
+    std::shared_ptr<const EmbeddingsGallery> gallery;
+    try {
+        gallery = std::make_shared<const EmbeddingsGallery>(path_, threshold_, landmarks_det_, image_reid_,
+                                                            cache_, current.get(), index_type_,
+                                                            precision_);
+    } catch (const std::exception& error) {
+        // the current gallery stays in use until the files change again
+        slog::warn << "Cannot update the face gallery from " << path_ << ": " << error.what() << slog::endl;
+        return false;
+    }
+    signature_ = Signature(*gallery);
+    std::atomic_store(&gallery_, gallery);
+    roster_.Publish(MakeRoster(*gallery));
+    slog::info << "Updated the face gallery from " << path_ << ", " << gallery->GetImagePaths().size()
+               << " images" << slog::endl;
+    return true;
+}
+
+void LiveGallery::WatchLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cv_.wait_for(lock, check_interval_, [this] { return stopped_; })) {
+        lock.unlock();
+        Reload();
+        lock.lock();
+    }
+}
@@ -13,14 +13,18 @@
 #include <map>
 #include <algorithm>
 #include <ie_iextension.h>
+#include <cstdlib>
 #include <cstring>
 #include "action_detector.hpp"
 #include "cnn.hpp"
 #include "detector.hpp"
 #include "face_reid.hpp"
+#include "live_gallery.hpp"
+#include "track_identity.hpp"
 #include "tracker.hpp"
 #include "image_grabber.hpp"
 #include "logger.hpp"
+#include "pipeline.hpp"
 #include <thread>
 #include <queue>
 #include <atomic>
@@ -38,10 +42,7 @@
 #include <opencv2/videoio.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
-#include <opencv2/dnn.hpp>
 
-#include <boost/property_tree/ptree.hpp>
-#include <boost/property_tree/json_parser.hpp>
 #include <boost/foreach.hpp>
 
 #include"classroom_analytics.hpp"
@@ -50,85 +51,47 @@
 
 using namespace std;
 using namespace cv;
-using namespace dnn;
 
 int totalEmotions = 0;
 int happinessEmotions = 0;
 // OpenCV related variables
-Mat frame, blob, sentBlob, poseBlob;
 int delay = 5;
-Net net, sentnet, posenet;
-bool sentChecked = false;
-bool poseChecked = false;
-
-int backendId;
-int targetId;
 float confidenceFace;
 float confidenceMood;
 
-string subject;
-string checkTime;
-
 // flag to control background threads
 atomic<bool> keepRunning(true);
 
 // flag to handle UNIX signals
 static volatile sig_atomic_t sig_caught = 0;
 
-// currentInfo contains the latest ClassroomInfo tracked by the application.
-ClassroomInfo currentInfo;
-queue<Mat> nextImage;
 String currentPerf;
 
-mutex m, m1, m2;
-
-// nextImageAvailable returns the next image from the queue in a thread-safe way
-Mat nextImageAvailable();
-// addImage adds an image to the queue in a thread-safe way
-ClassroomInfo getCurrentInfo();
-
-Mat nextImageAvailable() {
-	Mat rtn;
-	m.lock();
-	if (!nextImage.empty()) {
-		rtn = nextImage.front();
-		nextImage.pop();
-	}
-	m.unlock();
-	return rtn;
+// publishFrame hands a frame and its faces to the sentiment worker, a frame that
+// was not picked up yet is replaced by the newer one
+void publishFrame(ClassroomState& state, size_t index, const Mat& img,
+		const vector<Rect>& faces, const vector<float>& confidences) {
+	std::shared_ptr<StampedFrame> stamped = std::make_shared<StampedFrame>();
+	stamped->index = index;
+	stamped->timestamp = chrono::steady_clock::now();
+	stamped->image = img;
+	stamped->faces = faces;
+	stamped->confidences = confidences;
+	state.frames.Publish(stamped);
 }
 
-// addImage adds an image to the queue in a thread-safe way
-void addImage(Mat img) {
-	m.lock();
-	if (nextImage.empty()) {
-		nextImage.push(img);
-	}
-	m.unlock();
-}
-
-std::vector<std::string> getStudentNames(std::string path) {
-    boost::property_tree::ptree pt;
-    boost::property_tree::read_json(path, pt);
-    using boost::property_tree::ptree;
-    ptree::const_iterator end = pt.end();
-    std::vector<std::string> students;
-    for (ptree::const_iterator it = pt.begin(); it != end; ++it) {
-       students.push_back(it->first);
-    }
-   return students;
-}
-// getCurrentInfo returns the most-recent ClassroomInfo for the application.
-ClassroomInfo getCurrentInfo() {
+// getCurrentInfo returns the most-recent ClassroomInfo for the classroom.
+ClassroomInfo getCurrentInfo(ClassroomState& state) {
 	ClassroomInfo rtn;
-	m2.lock();
-	rtn = currentInfo;
-	m2.unlock();
+	state.m2.lock();
+	rtn = state.currentInfo;
+	state.m2.unlock();
 	return rtn;
 }
 
-void updateInfo(ClassroomInfo info) {
-	m2.lock();
+void updateInfo(ClassroomState& state, ClassroomInfo info) {
+	ClassroomInfo& currentInfo = state.currentInfo;
+	state.m2.lock();
 	if (currentInfo.students < info.students) {
 		currentInfo.students = info.students;
 	}
@@ -142,7 +105,7 @@ void updateInfo(ClassroomInfo info) {
 			currentInfo.sent[s] = info.sent[s];
 		}
 	}
-	m2.unlock();
+	state.m2.unlock();
 }
 
 //Classroom happiness index
@@ -173,114 +136,91 @@ double attentiveCal(int totalStudents, int attentiveStudents) {
 }
 
 // Function called by worker thread to process the next available video frame.
-void frameRunner() {
-	while (keepRunning.load()) {
-		Mat next = nextImageAvailable();
-		if (!next.empty()) {
-			// convert to 4d vector as required by model, and set as input
-			blobFromImage(next, blob, 1.0, Size(672, 384));
-			net.setInput(blob);
-			Mat prob = net.forward();
-
-			// get faces
-			vector<Rect> faces;
-			std::vector<float> confidences;
-			int looking = 0;
-			float* data = (float*)prob.data;
-			for (size_t i = 0; i < prob.total(); i += 7)
-			{
-				float confidence = data[i + 2];
-				if (confidence > confidenceFace)
-				{
-					int left = (int)(data[i + 3] * frame.cols);
-					int top = (int)(data[i + 4] * frame.rows);
-					int right = (int)(data[i + 5] * frame.cols);
-					int bottom = (int)(data[i + 6] * frame.rows);
-					int width = right - left + 1;
-					int height = bottom - top + 1;
-
-					faces.push_back(Rect(left, top, width, height));
-					confidences.push_back(confidence);
-				}
-			}
-			//int detSentiment;
-			map<Sentiment, int> sent = {
-				{Neutral, 0},
-				{Happy, 0},
-				{Confused, 0},
-				{Surprised, 0},
-				{Anger, 0},
-				{Unknown, 0}
-			};
-			// look for poses
-			for(auto const& r: faces) {
-				// make sure the face rect is completely inside the main Mat
-				if ((r & Rect(0, 0, next.cols, next.rows)) != r) {
-					continue;
-				}
-
-				std::vector<Mat> outs;
-				std::vector<String> names{"angle_y_fc", "angle_p_fc", "angle_r_fc"};
-				cv::Mat face = next(r);
-
-				// convert to 4d vector, and process thru neural network
-				blobFromImage(face, poseBlob, 1.0, Size(60, 60));
-				posenet.setInput(poseBlob);
-				posenet.forward(outs, names);
-				poseChecked = true;
-				// the shopper is looking if their head is tilted within a 45 degree angle relative to the shelf
-				if ( (outs[0].at<float>(0) > -22.5) && (outs[0].at<float>(0) < 22.5) &&
-						(outs[1].at<float>(0) > -22.5) && (outs[1].at<float>(0) < 28.5) ) {
+// It sleeps until a frame is published and leaves once the frame ring is closed.
+// The faces come from the face detection stage, so the frame is not detected twice,
+// and all faces of a frame go through head pose and emotions in batches.
+void frameRunner(ClassroomState& state, HeadPoseDetection& headPoseDetector, EmotionsDetection& emotionsDetector) {
+	// on frames skipped by a cadence the counts of its last run are carried forward
+	int looking = 0;
+	map<Sentiment, int> sent = {
+		{Neutral, 0},
+		{Happy, 0},
+		{Confused, 0},
+		{Surprised, 0},
+		{Anger, 0},
+		{Unknown, 0}
+	};
+	StampedFramePtr stamped;
+	while (state.frames.WaitLatest(&stamped)) {
+		const Mat& next = stamped->image;
+
+		// get faces, make sure the face rect is completely inside the main Mat
+		vector<Mat> faces;
+		for (size_t i = 0; i < stamped->faces.size(); i++) {
+			const Rect& r = stamped->faces[i];
+			if (stamped->confidences[i] > confidenceFace && (r & Rect(0, 0, next.cols, next.rows)) == r)
+				faces.push_back(next(r));
+		}
+		// look for poses
+		if (state.headPoseCadence.ShouldRun(stamped->index)) {
+			looking = 0;
+			vector<HeadPoseDetection::Results> poses;
+			headPoseDetector.Compute(faces, &poses);
+			for (const auto& pose : poses) {
+				// the student is looking if their head is tilted within a 45 degree angle relative to the board
+				if ( (pose.angle_y > -22.5) && (pose.angle_y < 22.5) &&
+						(pose.angle_p > -22.5) && (pose.angle_p < 28.5) ) {
 					looking++;
 				}
+			}
+			state.headPoseCadence.Feedback(faces.size());
+		}
 
-				// convert to 4d vector, and propagate through sentiment Neural Network
-				blobFromImage(face, sentBlob, 1.0, Size(64, 64));
-				sentnet.setInput(sentBlob);
-				Mat prob = sentnet.forward();
-				sentChecked = true;
-
-				// flatten the result from [1, 5, 1, 1] to [1, 5]
-				Mat flat = prob.reshape(1, 5);
-				// Find the max in returned list of sentiments
-				Point maxLoc;
-				double confidence;
-				minMaxLoc(flat, 0, &confidence, 0, &maxLoc);
+		// propagate through sentiment Neural Network and find the max in returned list of sentiments
+		if (state.emotionsCadence.ShouldRun(stamped->index)) {
+			for (auto& element : sent) {
+				element.second = 0;
+			}
+			vector<EmotionsDetection::Results> emotions;
+			emotionsDetector.Compute(faces, &emotions);
+			for (const auto& probabilities : emotions) {
+				auto maxIt = std::max_element(probabilities.begin(), probabilities.end());
 				Sentiment s;
-				if (confidence > static_cast<double>(confidenceMood)) {
-					s = static_cast<Sentiment>(maxLoc.y);
+				if (*maxIt > confidenceMood) {
+					s = static_cast<Sentiment>(maxIt - probabilities.begin());
 				} else {
 					s = Unknown;
 				}
 				sent[s] = sent.at(s) + 1;
 			}
-			ClassroomInfo info;
-			info.students = faces.size();
-			info.sent = sent;
-			info.lookers = looking;
-			updateInfo(info);
+			state.emotionsCadence.Feedback(faces.size());
 		}
+		ClassroomInfo info;
+		info.students = faces.size();
+		info.sent = sent;
+		info.lookers = std::min<int>(looking, faces.size());
+		updateInfo(state, info);
 	}
 }
 
 // Reset curret sent pose data 
-void resetCurrentInfo()
+void resetCurrentInfo(ClassroomState& state)
 {
-	m2.lock();
-	ClassroomInfo rtn = currentInfo;
+	ClassroomInfo& currentInfo = state.currentInfo;
+	state.m2.lock();
 	currentInfo.students = 0;
 	currentInfo.lookers = 0;
 	for (pair<Sentiment, int> element : currentInfo.sent) {
 		Sentiment s = element.first;		
 		currentInfo.sent[s] = 0;
 	}
-	m2.unlock();
+	state.m2.unlock();
 }
 
 // 
-void resetData() {
+void resetData(ClassroomState& state) {
 	while (keepRunning.load()) {
-		resetCurrentInfo();
+		resetCurrentInfo(state);
 		this_thread::sleep_for(chrono::seconds(2));
 	}
 }
@@ -288,8 +228,8 @@ void resetData() {
 // signal handler for the main thread
 void handle_sigterm(int signum)
 {
-	/* we only handle SIGTERM and SIGKILL here */
-	if (signum == SIGTERM) {
+	/* we only handle SIGTERM and SIGINT here, SIGKILL cannot be caught */
+	if (signum == SIGTERM || signum == SIGINT) {
 		cout << "Interrupt signal (" << signum << ") received" << endl;
 		sig_caught = 1;
 	}
@@ -302,47 +242,6 @@ void replaceWithExt(string& s, const string& newExt) {
 		s.replace(i+1, newExt.length(), newExt);
 	}
 }
-// Getting class name 
-void getclassName()   
-{
-	string timeTable="/opt/intel/openvino/inference_engine/samples/classroom_analytics/timetable.txt";
-	std::time_t t_old = std::time(0);   // get time now
-	std::tm* now_old = std::localtime(&t_old);
-	int presentTime = now_old->tm_hour;
-	string className,classTime;
-	std::string classtimeAndName;
-	std::ifstream inputfile(timeTable.c_str());
-
-	if (inputfile.is_open()){
-		inputfile.seekg (0, inputfile.end);
-		int length = inputfile.tellg();
-		inputfile.seekg (0, inputfile.beg); 
-		if(length == 0) {
-			std::cout << "timetable file is empty" << std::endl;
-			inputfile.close();
-			exit(0); 
-		}
-		vector<string> result;
-		while(getline(inputfile, classtimeAndName)){
-			boost::split(result, classtimeAndName,boost::is_any_of("-"));
-			className=result[0];
-			classTime=result[1];
-			stringstream verifyTime(classTime);
-			int timeCheck=0;
-			verifyTime >> timeCheck;
-			if(timeCheck == presentTime) {
-				subject=className;
-				checkTime=classTime;
-			}
-		}
-	} else {
-		std::cout << "timetable file does not exist" << std::endl;
-		inputfile.close();
-		exit(0);
-	}
-	inputfile.close();
-}
-
 using namespace InferenceEngine;
 
 namespace {
@@ -355,10 +254,11 @@ namespace {
 			float rect_scale_x_;
 			float rect_scale_y_;
 			static int const max_input_width_ = 1920;
-			std::string const window_name_ = "Classroom Analytics demo";
+			std::string const window_name_;
 
 		public:
-			Visualizer(bool enabled, cv::VideoWriter& writer) : enabled_(enabled), writer_(writer) {}
+			Visualizer(bool enabled, cv::VideoWriter& writer, const std::string& window_name = "Classroom Analytics demo")
+				: enabled_(enabled), writer_(writer), window_name_(window_name) {}
 
 			static cv::Size GetOutputSize(const cv::Size& input_size) {
 				if (input_size.width > max_input_width_) {
@@ -368,8 +268,13 @@ namespace {
 				return input_size;
 			}
 
+			// false when there is neither a window nor a video writer to render into
+			bool Active() const {
+				return enabled_ || writer_.isOpened();
+			}
+
 			void SetFrame(const cv::Mat& frame) {
-				if (enabled_ || writer_.isOpened()) {
+				if (Active()) {
 					frame_ = frame.clone();
 					rect_scale_x_ = 1;
 					rect_scale_y_ = 1;
@@ -393,7 +298,7 @@ namespace {
 
 			void DrawObject(cv::Rect rect, const std::string& label_to_draw,
 					const cv::Scalar& text_color, const cv::Scalar& bbox_color, bool plot_bg) {
-				if (enabled_ || writer_.isOpened()) {
+				if (Active()) {
 					if (rect_scale_x_ != 1 || rect_scale_y_ != 1) {
 						rect.x = cvRound(rect.x * rect_scale_x_);
 						rect.y = cvRound(rect.y * rect_scale_y_);
@@ -418,8 +323,15 @@ namespace {
 				}
 			}
 
+			void DrawText(const std::string& text, cv::Point pos) {
+				if (Active()) {
+					putText(frame_, text, pos, cv::FONT_HERSHEY_COMPLEX, 0.5, cv::Scalar(255, 255, 255));
+				}
+			}
+
 			void Finalize() const {
-				cv::destroyWindow(window_name_);
+				if (enabled_)
+					cv::destroyWindow(window_name_);
 				if (writer_.isOpened())
 					writer_.release();
 			}
@@ -496,31 +408,623 @@ namespace {
 		return face_track_id_to_label;
 	}
 
-}  
+	// Returns the label of the object that overlaps rect the most, or unknown if none overlaps it by half.
+	int GetLabelOfTheOverlappingObject(const cv::Rect& rect, const TrackedObjects& objects) {
+		int label = EmbeddingsGallery::unknown_id;
+		float max_iou = 0.5f;
+		for (const auto& object : objects) {
+			float iou = static_cast<float>((rect & object.rect).area()) / (rect | object.rect).area();
+			if (iou > max_iou) {
+				max_iou = iou;
+				label = object.label;
+			}
+		}
+		return label;
+	}
+
+	// FrameData carries one frame and everything the pipeline stages learn about it.
+	struct FrameData {
+		size_t stream_idx;
+		size_t frame_idx;
+		cv::Mat frame;
+		std::chrono::high_resolution_clock::time_point started;
+		std::chrono::steady_clock::time_point captured;
+
+		// detect stage, on frames skipped by a detector the detections of its last run
+		detection::DetectedObjects faces;
+		DetectedActions actions;
+		bool faces_detected;
+		bool actions_detected;
+
+		// face attributes stage, action tracking overlaps with face reid
+		bool faces_identified;
+		std::vector<int> face_ids;
+		std::vector<char> face_verified; // reid ran on the face, the others took the label of their track
+		std::vector<cv::Mat> face_embeddings; // reid embeddings of the verified faces, in face order
+		std::vector<int> face_frame_ids; // labels of those embeddings alone, they confirm the track identities
+		TrackedObjects tracked_actions;
+
+		// track stage
+		TrackedObjects tracked_faces;
+
+		// analytics stage
+		std::vector<std::string> face_labels;
+		ClassroomInfo info;
+		double happiness_index;
+		double attentive_index;
+		double participation_index;
+
+		FrameData(size_t stream_idx, size_t frame_idx, const cv::Mat& frame)
+			: stream_idx(stream_idx), frame_idx(frame_idx), frame(frame), started(std::chrono::high_resolution_clock::now()),
+			  captured(std::chrono::steady_clock::now()),
+			  faces_detected(false), actions_detected(false), faces_identified(false), happiness_index(0), attentive_index(0), participation_index(0) {}
+	};
+
+	using FrameDataPtr = std::unique_ptr<FrameData>;
+	using FrameQueue = BoundedQueue<FrameDataPtr>;
+
+	// ClassroomPipeline runs decode -> detect -> face attributes -> track -> analytics
+	// for one classroom on one worker thread per stage. The stages are joined by
+	// bounded queues, so consecutive frames overlap and a slow stage throttles the
+	// ones before it. Several classrooms share the loaded networks: the detectors are
+	// cloned with their own infer requests, the VectorCNN models and the head pose and
+	// emotions networks hand every call one of the requests of their shared pool.
+	// The analytics stage hands its points to the shared metrics writer. Fully processed
+	// frames of all classrooms go to one sink queue, which is read by the main thread
+	// because it owns the GUI. The last pipeline to finish closes it.
+	class ClassroomPipeline {
+		public:
+			ClassroomPipeline(size_t stream_idx, const std::string& section, const std::string& video_path,
+					const ActionDetection& action_detector, const detection::FaceDetection& face_detector,
+					const VectorCNN& landmarks_detector, const VectorCNN& face_reid,
+					HeadPoseDetection& head_pose_detector, EmotionsDetection& emotions_detector,
+					const LiveGallery& face_gallery,
+					const TrackerParams& tracker_reid_params, const TrackerParams& tracker_action_params,
+					SharedRoster& roster, Timetable& timetable, size_t queue_size, size_t detect_requests,
+					const CadenceConfig& cadences, const TrackIdentityParams& track_identity_params,
+					bool live, InfluxWriter& metrics,
+					const std::vector<std::chrono::seconds>& rollup_windows,
+					FrameQueue& sink, std::atomic<int>& running)
+				: stream_idx_(stream_idx), section_(section), video_path_(video_path), cap_(video_path),
+				  action_detector_(action_detector), face_detector_(face_detector),
+				  landmarks_detector_(landmarks_detector), face_reid_(face_reid),
+				  head_pose_detector_(head_pose_detector), emotions_detector_(emotions_detector),
+				  face_gallery_(face_gallery),
+				  tracker_reid_(tracker_reid_params), tracker_action_(tracker_action_params),
+				  roster_(roster), detect_requests_(std::max<size_t>(detect_requests, 1)),
+				  action_cadence_(cadences.action_detection, cadences.adaptive),
+				  face_cadence_(cadences.face_detection, cadences.adaptive),
+				  reid_cadence_(cadences.face_reid, cadences.adaptive), track_identities_(track_identity_params),
+				  live_(live), captured_(2), timetable_(timetable), stopped_(false),
+				  decoded_(queue_size), detected_(queue_size), identified_(queue_size),
+				  tracked_(queue_size), metrics_(metrics), rollup_(section, rollup_windows),
+				  sink_(sink), running_(running) {
+				state_.currentInfo.students = 0;
+				state_.currentInfo.lookers = 0;
+				state_.currentInfo.sent = {
+					{Neutral, 0},
+					{Happy, 0},
+					{Confused, 0},
+					{Surprised, 0},
+					{Anger, 0},
+					{Unknown, 0}
+				};
+				state_.headPoseCadence = Cadence(cadences.head_pose, cadences.adaptive);
+				state_.emotionsCadence = Cadence(cadences.emotions, cadences.adaptive);
+			}
+
+			~ClassroomPipeline() {
+				Stop();
+				Join();
+			}
+
+			// Open grabs the first frame. It returns false if the source cannot be read.
+			bool Open() {
+				slog::info << "Reading video '" << video_path_ << "' for section " << section_ << slog::endl;
+				if (!cap_.IsOpened()) {
+					slog::err << "Cannot open the video " << video_path_ << slog::endl;
+					return false;
+				}
+				if (!cap_.GrabNext() || !cap_.Retrieve(first_frame_)) {
+					slog::err << "Can't read the first frame of " << video_path_ << slog::endl;
+					return false;
+				}
+				frame_size_ = first_frame_.size();
+				return true;
+			}
+
+			void Start() {
+				++running_;
+				workers_.emplace_back(frameRunner, std::ref(state_),
+						std::ref(head_pose_detector_), std::ref(emotions_detector_));
+				workers_.emplace_back(resetData, std::ref(state_));
+				if (live_) {
+					workers_.emplace_back(&ClassroomPipeline::CaptureStage, this, first_frame_);
+					workers_.emplace_back(&ClassroomPipeline::LiveDecodeStage, this);
+				} else {
+					workers_.emplace_back(&ClassroomPipeline::DecodeStage, this, first_frame_);
+				}
+				workers_.emplace_back(&ClassroomPipeline::DetectStage, this);
+				workers_.emplace_back(&ClassroomPipeline::FaceAttributesStage, this);
+				workers_.emplace_back(&ClassroomPipeline::TrackStage, this);
+				workers_.emplace_back(&ClassroomPipeline::AnalyticsStage, this);
+			}
+
+			// Stop makes every stage leave its loop without waiting for queued frames.
+			// Frames of this classroom that already reached the sink should be dropped.
+			void Stop() {
+				stopped_ = true;
+				captured_.Close();
+				state_.frames.Close();
+				decoded_.Close();
+				detected_.Close();
+				identified_.Close();
+				tracked_.Close();
+			}
+
+			// Returns the number of captured frames that were never processed, live mode only.
+			size_t DroppedFrames() const {
+				return captured_.Dropped();
+			}
+
+			bool Live() const { return live_; }
+
+			bool Stopped() const {
+				return stopped_.load();
+			}
+
+			// Join also waits for the sentiment workers, so keepRunning has to be cleared first.
+			void Join() {
+				for (auto& worker : workers_) {
+					if (worker.joinable())
+						worker.join();
+				}
+			}
+
+			const std::string& Section() const { return section_; }
+			int GetFPS() const { return cap_.GetFPS(); }
+			std::string GetVideoPath() const { return cap_.GetVideoPath(); }
+			const cv::Size& FrameSize() const { return frame_size_; }
+
+			void PrintPerformanceCounts(const std::string& action_device, const std::string& face_device) {
+				// the detect stage has fetched every request it started
+				action_detector_.PrintPerformanceCounts(action_device);
+				face_detector_.PrintPerformanceCounts(face_device);
+			}
+
+			// Only valid once the pipeline has been joined.
+			const Tracker& FaceTracker() const {
+				return tracker_reid_;
+			}
+
+			// Only valid once the pipeline has been joined.
+			const std::vector<std::map<int, int>>& FaceObjIdToActionMaps() const {
+				return face_obj_id_to_action_maps_;
+			}
+
+		private:
+			// GrabNextFrame reads the next frame into a fresh buffer, the previous one is
+			// still used downstream. Video files are looped, cameras end the stream.
+			bool GrabNextFrame(cv::Mat* image) {
+				bool is_last_frame = !cap_.GrabNext();
+				if (is_last_frame && video_path_ != "cam") // Looping the videostream if-only-if it is a videofile.
+				{
+					if (cap_.LoopVideo()){
+						is_last_frame = !cap_.GrabNext();
+					}
+				}
+				if (is_last_frame)
+					return false;
+				*image = cv::Mat();
+				cap_.Retrieve(*image);
+				frame_size_ = image->size();
+				return true;
+			}
+
+			void DecodeStage(cv::Mat image) {
+				size_t frame_idx = 0;
+				bool is_last_frame = false;
+				while (!is_last_frame && keepRunning.load()) {
+					FrameDataPtr data(new FrameData(stream_idx_, frame_idx++, image));
+					if (!decoded_.Push(std::move(data)))
+						break;
+
+					is_last_frame = !GrabNextFrame(&image);
+				}
+				decoded_.Close();
+			}
+
+			// In live mode CaptureStage drains the device at its own pace, so the
+			// driver buffer never fills up, and keeps only the newest frames.
+			void CaptureStage(cv::Mat image) {
+				size_t capture_idx = 0;
+				do {
+					std::shared_ptr<StampedFrame> stamped = std::make_shared<StampedFrame>();
+					stamped->index = capture_idx++;
+					stamped->timestamp = std::chrono::steady_clock::now();
+					stamped->image = image;
+					captured_.Publish(stamped);
+				} while (!stopped_ && keepRunning.load() && GrabNextFrame(&image));
+				captured_.Close();
+			}
+
+			// LiveDecodeStage feeds the pipeline with the newest captured frame whenever
+			// the detect stage is ready for one, the frames captured meanwhile are dropped.
+			void LiveDecodeStage() {
+				size_t frame_idx = 0;
+				StampedFramePtr stamped;
+				while (keepRunning.load() && captured_.WaitLatest(&stamped)) {
+					FrameDataPtr data(new FrameData(stream_idx_, frame_idx++, stamped->image));
+					data->captured = stamped->timestamp;
+					if (!decoded_.Push(std::move(data)))
+						break;
+				}
+				decoded_.Close();
+			}
+
+			// DetectStage keeps up to detect_requests_ frames in flight on the face and
+			// action detectors and passes them on in decode order. Frames skipped by a
+			// detector's cadence carry the detections of its last run.
+			void DetectStage() {
+				std::deque<FrameDataPtr> in_flight;
+				FrameDataPtr data;
+				while (decoded_.Pop(&data)) {
+					data->faces_detected = face_detector_.enabled() && face_cadence_.ShouldRun(data->frame_idx);
+					if (data->faces_detected)
+						face_detector_.SubmitFrame(data->frame, data->frame_idx);
+					data->actions_detected = action_detector_.enabled() && action_cadence_.ShouldRun(data->frame_idx);
+					if (data->actions_detected)
+						action_detector_.SubmitFrame(data->frame, data->frame_idx);
+					in_flight.push_back(std::move(data));
+
+					if (in_flight.size() >= detect_requests_ && !PassOldestDetection(&in_flight))
+						break;
+				}
+				// frames still in flight are passed on at the end of the stream and dropped after Stop()
+				while (!in_flight.empty())
+					PassOldestDetection(&in_flight);
+				detected_.Close();
+				state_.frames.Close();
+			}
+
+			bool PassOldestDetection(std::deque<FrameDataPtr>* in_flight) {
+				FrameDataPtr data = std::move(in_flight->front());
+				in_flight->pop_front();
+				if (data->faces_detected) {
+					size_t frame_idx = face_detector_.FetchOldest(&last_faces_);
+					SCR_CHECK_EQ(frame_idx, data->frame_idx);
+					face_cadence_.Feedback(last_faces_.size());
+				}
+				data->faces = last_faces_;
+				if (data->actions_detected) {
+					size_t frame_idx = action_detector_.FetchOldest(&last_actions_);
+					SCR_CHECK_EQ(frame_idx, data->frame_idx);
+					action_cadence_.Feedback(last_actions_.size());
+				}
+				data->actions = last_actions_;
+
+				// head pose and emotions only see fresh face boxes, the carried ones lag behind the frame
+				if (data->faces_detected || !face_detector_.enabled()) {
+					std::vector<cv::Rect> face_rects;
+					std::vector<float> face_confidences;
+					for (const auto& face : data->faces) {
+						face_rects.push_back(face.rect);
+						face_confidences.push_back(face.confidence);
+					}
+					publishFrame(state_, data->frame_idx, data->frame, face_rects, face_confidences);
+				}
+
+				return detected_.Push(std::move(data));
+			}
+
+			void FaceAttributesStage() {
+				FrameDataPtr data;
+				while (detected_.Pop(&data)) {
+					// reid only runs on fresh face detections
+					data->faces_identified = data->faces_detected && reid_cadence_.ShouldRun(data->frame_idx);
+					std::future<std::vector<cv::Mat>> pending_embeddings;
+					std::vector<size_t> verified_faces;
+					if (data->faces_identified) {
+						// faces of confidently labelled tracks skip reid until they are due for a check
+						data->face_ids.assign(data->faces.size(), EmbeddingsGallery::unknown_id);
+						data->face_verified.assign(data->faces.size(), 0);
+						std::vector<cv::Mat> face_rois;
+						for (size_t i = 0; i < data->faces.size(); i++) {
+							const cv::Rect& rect = data->faces[i].rect;
+							data->face_ids[i] = track_identities_.TrustedLabel(rect, data->frame_idx);
+							if (data->face_ids[i] != EmbeddingsGallery::unknown_id)
+								continue;
+							data->face_verified[i] = 1;
+							verified_faces.push_back(i);
+							// AlignFaces warps in place, so keep it away from the shared frame buffer
+							face_rois.push_back(data->frame(rect).clone());
+						}
+						if (!face_rois.empty()) {
+							// landmarks, alignment and reid run on a reid worker, off the stage thread
+							pending_embeddings = face_reid_.ComputeAsync(face_rois, cv::Size(),
+									[this](std::vector<cv::Mat>* rois) {
+										std::vector<cv::Mat> landmarks;
+										landmarks_detector_.Compute(*rois, &landmarks, cv::Size(2, 5));
+										AlignFaces(rois, &landmarks);
+									});
+						}
+					}
+
+					// action tracking does not depend on the faces, run it while landmarks and reid are busy
+					if (data->actions_detected) {
+						TrackedObjects tracked_action_objects;
+						for (const auto& action : data->actions) {
+							tracked_action_objects.emplace_back(action.rect, action.detection_conf, action.label);
+						}
+						tracker_action_.Process(data->frame, tracked_action_objects, data->frame_idx);
+					}
+					data->tracked_actions = tracker_action_.TrackedDetectionsWithLabels();
+
+					if (data->faces_identified) {
+						if (!verified_faces.empty()) {
+							data->face_embeddings = pending_embeddings.get();
+							std::shared_ptr<const EmbeddingsGallery> gallery = face_gallery_.Current();
+							data->face_frame_ids = gallery->GetIDsByEmbeddings(data->face_embeddings);
+							// report the match through the running mean of every track, steadier than a single frame
+							std::vector<cv::Mat> embeddings(verified_faces.size());
+							bool aggregated = false;
+							for (size_t j = 0; j < verified_faces.size(); j++) {
+								const detection::DetectedObject& face = data->faces[verified_faces[j]];
+								embeddings[j] = track_identities_.Aggregate(face.rect, data->face_embeddings[j],
+																			FaceQuality(face.rect, face.confidence));
+								aggregated = aggregated || !embeddings[j].empty();
+								if (embeddings[j].empty())
+									embeddings[j] = data->face_embeddings[j];
+							}
+							std::vector<int> ids = aggregated ? gallery->GetIDsByEmbeddings(embeddings) : data->face_frame_ids;
+							for (size_t j = 0; j < ids.size(); j++)
+								data->face_ids[verified_faces[j]] = ids[j];
+						}
+						reid_cadence_.Feedback(data->faces.size());
+					}
+
+					if (!identified_.Push(std::move(data)))
+						break;
+				}
+				identified_.Close();
+			}
+
+			// TrackStage feeds fresh face detections to the tracker. Faces that were not
+			// identified on this frame take the label of the tracked face they overlap.
+			void TrackStage() {
+				FrameDataPtr data;
+				while (identified_.Pop(&data)) {
+					if (data->faces_detected) {
+						TrackedObjects previous_faces;
+						if (!data->faces_identified)
+							previous_faces = tracker_reid_.TrackedDetectionsWithLabels();
+
+						TrackedObjects tracked_face_objects;
+						for (size_t i = 0; i < data->faces.size(); i++) {
+							int label = EmbeddingsGallery::unknown_id;
+							if (!data->faces_identified)
+								label = GetLabelOfTheOverlappingObject(data->faces[i].rect, previous_faces);
+							else if (!data->face_ids.empty())
+								label = data->face_ids[i];
+							tracked_face_objects.emplace_back(data->faces[i].rect, data->faces[i].confidence, label);
+						}
+						tracker_reid_.Process(data->frame, tracked_face_objects, data->frame_idx);
+					}
+					data->tracked_faces = tracker_reid_.TrackedDetectionsWithLabels();
+
+					// remember which tracks reid just confirmed, the face attributes stage skips them for a while
+					std::vector<VerifiedFace> verified_faces;
+					for (size_t i = 0, j = 0; i < data->face_verified.size(); i++) {
+						if (!data->face_verified[i])
+							continue;
+						const detection::DetectedObject& face = data->faces[i];
+						cv::Mat embedding = j < data->face_embeddings.size() ? data->face_embeddings[j] : cv::Mat();
+						int label = j < data->face_frame_ids.size() ? data->face_frame_ids[j] : data->face_ids[i];
+						verified_faces.push_back({face.rect, label, embedding,
+												  FaceQuality(face.rect, face.confidence)});
+						j++;
+					}
+					track_identities_.Update(data->tracked_faces, verified_faces, data->frame_idx);
+
+					if (!tracked_.Push(std::move(data)))
+						break;
+				}
+				tracked_.Close();
+			}
+
+			void AnalyticsStage() {
+				FrameDataPtr data;
+				while (tracked_.Pop(&data)) {
+					std::map<int, int> frame_face_obj_id_to_action;
+					std::vector<int> seen_ids; // roster ids of the identified students
+					int participationCount = 0; // standing count variable
+					std::shared_ptr<const EmbeddingsGallery> gallery = face_gallery_.Current();
+					for (const auto& face : data->tracked_faces) {
+						std::string label_to_draw;
+						if (face.label != EmbeddingsGallery::unknown_id) {
+							label_to_draw += gallery->GetLabelByID(face.label);
+							seen_ids.push_back(face.label);
+						}
+						label_to_draw = label_to_draw.substr(label_to_draw.find("_")+1);
+
+						int person_ind = GetIndexOfTheNearestPerson(face, data->tracked_actions);
+						int action_ind = default_action_index;
+						if (person_ind >= 0) {
+							action_ind = data->tracked_actions[person_ind].label;
+						}
+
+						std::string participation = GetActionTextLabel(action_ind);
+						label_to_draw += "(" + participation + ")";
+						frame_face_obj_id_to_action[face.object_id] = action_ind;
+						if (participation == "standing" || participation == "raising_hand")
+							participationCount++;
+						data->face_labels.push_back(label_to_draw);
+					}
+					face_obj_id_to_action_maps_.push_back(frame_face_obj_id_to_action);
+
+					ClassroomInfo info = getCurrentInfo(state_);
+					if (info.students > 0) {
+						int totalEmotions = info.sent[Neutral] + info.sent[Happy] + info.sent[Confused] +
+							info.sent[Surprised] + info.sent[Anger] + info.sent[Unknown];
+						data->happiness_index = happinessCal(totalEmotions, info.sent[Happy]);
+						data->attentive_index = attentiveCal(info.students, info.lookers);
+						data->participation_index = participationCal(participationCount, info.students);
+					}
+					data->info = info;
+
+					// the timetable answers from its cache until the next slot boundary
+					auto now = std::chrono::system_clock::now();
+					TimetableSlot slot;
+					std::string session = "No_Time_Assigned";
+					subject_ = session;
+					if (timetable_.Lookup(now, &slot)) {
+						subject_ = slot.subject;
+						session = slot.subject + "-" + std::to_string(slot.start);
+					}
+
+					// the writer only queues the points, it never blocks on the database
+					std::vector<LinePoint> points;
+					if (info.students != 0) { // No need to insert data if students strength is '0'.
+						if (rollup_.Enabled()) {
+							rollup_.Add({{"classname", subject_}},
+									{{"studentpresent", info.students},
+									{"participation", data->participation_index},
+									{"happiness", data->happiness_index},
+									{"attentivity", data->attentive_index}},
+									now, &points);
+						} else {
+							// window=0 marks the per-frame points, the dashboard selects them like a window
+							points.push_back(LinePoint(section_)
+									.Tag("classname", subject_)
+									.Tag("window", "0")
+									.Field("studentpresent", info.students)
+									.Field("participation", data->participation_index)
+									.Field("happiness", data->happiness_index)
+									.Field("attentivity", data->attentive_index)
+									.Time(now));
+						}
+					}
+					// windows are closed by time, also while nobody is in the classroom
+					rollup_.Flush(now, &points);
+					for (const auto& point : points)
+						metrics_.Write(point);
+
+					// one attendance report per timetable slot, written once the slot is over
+					AttendanceReport report;
+					if (attendance_.SwitchSession(session, subject_, roster_.Current(), now, &report))
+						WriteAttendance(report);
+					attendance_.Observe(seen_ids, now);
+
+					if (!sink_.Push(std::move(data)))
+						break;
+				}
+				AttendanceReport report;
+				if (attendance_.EndSession(std::chrono::system_clock::now(), &report))
+					WriteAttendance(report);
+				std::vector<LinePoint> points;
+				rollup_.FlushAll(&points);
+				for (const auto& point : points)
+					metrics_.Write(point);
+				if (--running_ == 0)
+					sink_.Close();
+			}
+
+			void WriteAttendance(const AttendanceReport& report) {
+				if (report.subject == "No_Time_Assigned")
+					return;
+				// points of one series with equal timestamps overwrite each other, so every absentee gets its own millisecond
+				int absent = 0;
+				for (const auto& record : report.records) {
+					const std::string& label = report.roster->Label(record.id);
+					std::string name = label.substr(label.find("_") + 1);
+					LinePoint point("Attendance");
+					point.Tag("subjectName", report.subject)
+						.Tag("section", section_)
+						.Tag("student", name)
+						.Field("present", record.present ? 1.0 : 0.0);
+					if (record.present) {
+						point.Field("first_seen", std::chrono::duration_cast<std::chrono::milliseconds>(
+									record.first_seen.time_since_epoch()).count())
+							.Field("last_seen", std::chrono::duration_cast<std::chrono::milliseconds>(
+									record.last_seen.time_since_epoch()).count());
+					} else {
+						metrics_.Write(LinePoint("AbsentList")
+								.Tag("subjectName", report.subject)
+								.Tag("section", section_)
+								.Field("absentName", name)
+								.Time(report.end + std::chrono::milliseconds(absent++)));
+					}
+					metrics_.Write(point.Time(report.start));
+				}
+			}
+
+			const size_t stream_idx_;
+			const std::string section_;
+			const std::string video_path_;
+			ImageGrabber cap_;
+			cv::Mat first_frame_;
+			cv::Size frame_size_;
+			ActionDetection action_detector_;
+			detection::FaceDetection face_detector_;
+			const VectorCNN& landmarks_detector_;
+			const VectorCNN& face_reid_;
+			HeadPoseDetection& head_pose_detector_;
+			EmotionsDetection& emotions_detector_;
+			const LiveGallery& face_gallery_;
+			Tracker tracker_reid_;
+			Tracker tracker_action_;
+			SharedRoster& roster_;
+			AttendanceTracker attendance_;
+			const size_t detect_requests_;
+			Cadence action_cadence_;
+			Cadence face_cadence_;
+			Cadence reid_cadence_;
+			TrackIdentityCache track_identities_;
+			detection::DetectedObjects last_faces_;
+			DetectedActions last_actions_;
+			const bool live_;
+			LatestRing<StampedFramePtr> captured_;
+			ClassroomState state_;
+			Timetable& timetable_;
+			std::string subject_;
+			std::atomic<bool> stopped_;
+
+			FrameQueue decoded_;
+			FrameQueue detected_;
+			FrameQueue identified_;
+			FrameQueue tracked_;
+			InfluxWriter& metrics_;
+			WindowedRollup rollup_;
+			FrameQueue& sink_;
+			std::atomic<int>& running_;
+			std::vector<std::thread> workers_;
+
+			std::vector<std::map<int, int>> face_obj_id_to_action_maps_;
+	};
+
+}
 
 int main(int argc, char* argv[]) 
 {
 
 	try {
-		String model,Participation;
-		String config,ad_weights_path,fr_weights_path,lm_weights_path,fd_weights_path,headposeconfig;
-		String sentmodel, posemodel,ad_model_path,fr_model_path,lm_model_path,fd_model_path;
+		String ad_weights_path,fr_weights_path,lm_weights_path,fd_weights_path,headposeconfig;
+		String ad_model_path,fr_model_path,lm_model_path,fd_model_path;
 		String sentconfig, poseconfig,fg_model_path;
 		String d_act,d_fd,d_lm,d_reid,d_hp,d_em;
-		string dbResp, connectionResp, classSection,influxdbIp;
+		string influxdbIp;
 		int noShow=0;
+		size_t queueSize;
+		int numRequests;
+		bool liveMode;
+		std::chrono::milliseconds latencyTarget;
 
-		std::vector<std::string> captured; // Identifying student names
 		CommandLineParser parser(argc, argv, keys); 
 		if(argc == 1 || parser.has("help")) {
 			parser.printMessage();
 			return -1;
 		}
 
-		auto video_path = parser.get<String>("input");
-		config = parser.get<String>("config");
-		backendId = parser.get<int>("backend");
-		targetId = parser.get<int>("target");
 		confidenceFace = parser.get<float>("faceconf");
 		confidenceMood = parser.get<float>("moodconf");
 		sentconfig = parser.get<String>("sentconfig");
@@ -530,7 +1034,6 @@ int main(int argc, char* argv[])
 		fr_model_path = parser.get<String>("facereidentificationconfig");
 		fg_model_path = parser.get<String>("facegallerypath");
 		fd_model_path = parser.get<String>("config");
-		classSection = parser.get<String>("section");
 		noShow       = parser.get<int>("noshow");
 		d_act        = parser.get<String>("d_act");
 		d_hp         = parser.get<String>("d_hp");
@@ -539,13 +1042,48 @@ int main(int argc, char* argv[])
 		d_lm         = parser.get<String>("d_lm");
 		d_reid       = parser.get<String>("d_reid");
 		influxdbIp   = parser.get<String>("influxip");
+		InfluxConfig influx_config;
+		influx_config.host = influxdbIp.substr(0, influxdbIp.rfind(':'));
+		if (influxdbIp.rfind(':') != std::string::npos) {
+			std::string port = influxdbIp.substr(influxdbIp.rfind(':') + 1);
+			if (port.empty() || port.size() > 5 || port.find_first_not_of("0123456789") != std::string::npos ||
+				std::atoi(port.c_str()) < 1 || std::atoi(port.c_str()) > 65535) {
+				slog::err << "Invalid InfluxDB port in --influxip=" << influxdbIp << ", expected host:port with a port in 1..65535" << slog::endl;
+				return 1;
+			}
+			influx_config.port = std::atoi(port.c_str());
+		}
+		if (influx_config.host.empty()) {
+			slog::err << "Missing InfluxDB host in --influxip=" << influxdbIp << slog::endl;
+			return 1;
+		}
+		influx_config.batch_size = parser.get<int>("db_batch");
+		influx_config.flush_interval = std::chrono::milliseconds(parser.get<int>("db_flush_ms"));
+		influx_config.spool_dir = parser.get<String>("db_spool");
+		influx_config.replay_rate = parser.get<int>("db_replay_rate");
+		std::vector<std::chrono::seconds> rollupWindows;
+		std::string rollupList = parser.get<String>("rollup");
+		std::vector<std::string> rollupItems;
+		boost::split(rollupItems, rollupList, boost::is_any_of(","));
+		for (const auto& item : rollupItems) {
+			if (!item.empty() && std::atoi(item.c_str()) > 0)
+				rollupWindows.push_back(std::chrono::seconds(std::atoi(item.c_str())));
+		}
+		queueSize    = parser.get<int>("queuesize");
+		numRequests  = parser.get<int>("nireq");
+		CadenceConfig cadences;
+		cadences.action_detection = parser.get<int>("act_every");
+		cadences.face_detection   = parser.get<int>("fd_every");
+		cadences.face_reid        = parser.get<int>("reid_every");
+		cadences.head_pose        = parser.get<int>("hp_every");
+		cadences.emotions         = parser.get<int>("em_every");
+		cadences.adaptive         = parser.get<int>("adaptive_cadence") == 1;
+		TrackIdentityParams track_identity_params;
+		track_identity_params.verify_every = std::max(parser.get<int>("reid_verify_every"), 0);
+		track_identity_params.max_track_weight = std::max(parser.get<float>("reid_track_weight"), 0.0f);
+		liveMode     = parser.get<int>("live") == 1;
+		latencyTarget = std::chrono::milliseconds(parser.get<int>("latency"));
 
-		model = config;
-		replaceWithExt(model, "bin");
-		sentmodel = sentconfig;
-		replaceWithExt(sentmodel, "bin");
-		posemodel = poseconfig;
-		replaceWithExt(posemodel, "bin");
 		ad_weights_path = ad_model_path;
 		replaceWithExt(ad_weights_path, "bin");
 		lm_weights_path = lm_model_path;
@@ -555,24 +1093,38 @@ int main(int argc, char* argv[])
 		fd_weights_path = fd_model_path;
 		replaceWithExt(fd_weights_path, "bin");
 
+		// every input is a classroom, identified by its section
+		std::string inputs = parser.get<String>("input");
+		std::string classSections = parser.get<String>("section");
+		std::vector<std::string> video_paths, sections;
+		boost::split(video_paths, inputs, boost::is_any_of(","));
+		boost::split(sections, classSections, boost::is_any_of(","));
+		if (sections.size() == 1 && video_paths.size() > 1) {
+			for (size_t i = 1; i < video_paths.size(); i++)
+				sections.push_back(sections[0] + "_" + std::to_string(i));
+		}
+		if (sections.size() != video_paths.size()) {
+			slog::err << "Got " << video_paths.size() << " inputs but " << sections.size() << " sections" << slog::endl;
+			return 1;
+		}
+
 		std::map<std::string, Core> plugins_for_devices;
 		std::vector<std::string> devices = {d_act, d_fd, d_lm,d_reid,d_hp,d_em};
 
-		std::string dbCreate = "curl -i -XPOST http://" + influxdbIp +":8086/query --data-urlencode "+"\""+"q=CREATE DATABASE Analytics"+"\"" +" >/dev/null 2>&1";
-		int ret = system(dbCreate.c_str());
-		if(ret != 0) {
-			std::cout <<"Failed to connect to DB : ret val "<< ret << std::endl;
-			exit(0);
+		// the analytics keep running without the database, the writer spools the points and retries
+		InfluxWriter metrics(influx_config);
+		if(!metrics.CreateDatabase()) {
+			slog::warn << "Failed to connect to DB at " << influxdbIp << ", retrying in the background" << slog::endl;
 		}
 
-		//getting student name from face gallary.json
-		std::vector<std::string> students;
-		students = getStudentNames(fg_model_path);
-
 		// Load Headpose detector
-		HeadPoseDetection headPoseDetector(poseconfig,d_hp,16,false,false, FLAGS_r);
+		// Faces of a frame are batched, CPU and GPU run partial batches with dynamic batching
+		auto supportsDynBatch = [](const std::string& device) {
+			return device.find("CPU") != std::string::npos || device.find("GPU") != std::string::npos;
+		};
+		HeadPoseDetection headPoseDetector(poseconfig,d_hp,16,supportsDynBatch(d_hp),false, FLAGS_r);
 		// Load emotion detector
-		EmotionsDetection emotionsDetector(sentconfig,d_em,16,false,false,FLAGS_r);
+		EmotionsDetection emotionsDetector(sentconfig,d_em,16,supportsDynBatch(d_em),false,FLAGS_r);
 
 		Core ie;
 
@@ -597,6 +1149,10 @@ int main(int argc, char* argv[])
 			plugins_for_devices[device] = ie;
 		}
 
+		// every classroom keeps numRequests requests of the detectors in flight, the shared
+		// networks get enough streams and requests to run all classrooms in parallel
+		const int numInputs = static_cast<int>(video_paths.size());
+
 		// Load action detector
 		ActionDetectorConfig action_config(ad_model_path, ad_weights_path);
 		action_config.plugin = plugins_for_devices[d_act];
@@ -604,6 +1160,8 @@ int main(int argc, char* argv[])
 		action_config.device = d_act;
 		action_config.enabled = !ad_model_path.empty();
 		action_config.detection_confidence_threshold = FLAGS_t_act;
+		action_config.num_requests = numRequests;
+		action_config.num_streams = numRequests * numInputs;
 		ActionDetection action_detector(action_config);
 
 		// Load face detector
@@ -617,11 +1175,14 @@ int main(int argc, char* argv[])
 		face_config.input_w = FLAGS_inw_fd;
 		face_config.increase_scale_x = FLAGS_exp_r_fd;
 		face_config.increase_scale_y = FLAGS_exp_r_fd;
+		face_config.num_requests = numRequests;
+		face_config.num_streams = numRequests * numInputs;
 		detection::FaceDetection face_detector(face_config);
 
 		// Load face reid
 		CnnConfig reid_config(fr_model_path, fr_weights_path);
 		reid_config.max_batch_size = 16;
+		reid_config.num_requests = numRequests * numInputs;
 		reid_config.enabled = face_config.enabled && !fr_model_path.empty() && !lm_model_path.empty();
 		reid_config.plugin = plugins_for_devices[d_reid];
 		reid_config.device = d_reid;
@@ -630,17 +1191,28 @@ int main(int argc, char* argv[])
 		// Load landmarks detector
 		CnnConfig landmarks_config(lm_model_path, lm_weights_path);
 		landmarks_config.max_batch_size = 16;
+		landmarks_config.num_requests = numRequests * numInputs;
 		landmarks_config.enabled = face_config.enabled && reid_config.enabled && !lm_model_path.empty();
 		landmarks_config.plugin = plugins_for_devices[d_lm];
 		landmarks_config.device = d_lm;
 		VectorCNN landmarks_detector(landmarks_config);
 
 
-		// Create face gallery
-		EmbeddingsGallery face_gallery(fg_model_path, FLAGS_t_reid, landmarks_detector, face_reid);
-		//EmbeddingsGallery face_gallery(FLAGS_fg, FLAGS_t_reid, landmarks_detector, face_reid);
-
-		// Create tracker for reid
+		// Create face gallery, the embeddings of unchanged images come from the cache
+		String fg_cache_path = parser.get<String>("fg_cache");
+		if (fg_cache_path.empty() && !fg_model_path.empty())
+			fg_cache_path = fg_model_path + ".cache";
+		uint64_t fg_models = HashFiles({lm_model_path, lm_weights_path, fr_model_path, fr_weights_path}, {d_lm, d_reid});
+		EmbeddingCache fg_cache(fg_cache_path, fg_models);
+		// edits of the gallery are picked up while running, identities keep their ids
+		LiveGallery face_gallery(fg_model_path, FLAGS_t_reid, landmarks_detector, face_reid, &fg_cache,
+				parser.get<String>("fg_index"), parser.get<String>("fg_precision"));
+		// the students every classroom checks attendance against, ids are the gallery ids
+		SharedRoster& roster = face_gallery.GetRoster();
+		// shared by the classrooms, parsed once and reloaded when the file changes
+		Timetable timetable(parser.get<String>("timetable"));
+
+		// Create tracker parameters for reid, every classroom has its own trackers
 		TrackerParams tracker_reid_params;
 		tracker_reid_params.min_track_duration = 1;
 		tracker_reid_params.forget_delay = 150;
@@ -651,9 +1223,7 @@ int main(int argc, char* argv[])
 		tracker_reid_params.max_num_objects_in_track = std::numeric_limits<int>::max();
 		tracker_reid_params.objects_type = "face";
 
-		Tracker tracker_reid(tracker_reid_params);
-
-		// Create Tracker for action recognition
+		// Create tracker parameters for action recognition
 		TrackerParams tracker_action_params;
 		tracker_action_params.min_track_duration = 8;
 		tracker_action_params.forget_delay = 150;
@@ -664,335 +1234,175 @@ int main(int argc, char* argv[])
 		tracker_action_params.max_num_objects_in_track = std::numeric_limits<int>::max();
 		tracker_action_params.objects_type = "action";
 
-		Tracker tracker_action(tracker_action_params);
+		// head Pose, one infer request per classroom
+		Load(headPoseDetector).into(plugins_for_devices[d_hp],d_hp,headPoseDetector.isBatchDynamic,numInputs);
+		// Emotions, one infer request per classroom
+		Load(emotionsDetector).into(plugins_for_devices[d_em],d_em,emotionsDetector.isBatchDynamic,numInputs);
 
-		// head Pose 
-		Load(headPoseDetector).into(plugins_for_devices[d_hp],d_hp,false);
-		// Emotions
-		Load(emotionsDetector).into(plugins_for_devices[d_em],d_em,false);
-
-
-		//cv::Mat frame, prev_frame;
-		cv::Mat prev_frame;
-		DetectedActions actions;
-		detection::DetectedObjects faces;
 
-		float total_time_ms = 0.f;
-		size_t num_frames = 0;
 		const char ESC_KEY = 27;
 		const cv::Scalar red_color(0, 0, 255);
 		const cv::Scalar green_color(0, 128, 0);
 		const cv::Scalar white_color(255, 255, 255);
-		std::vector<std::map<int, int>> face_obj_id_to_action_maps;
 
-		slog::info << "Reading video '" << video_path << "'" << slog::endl;
-		ImageGrabber cap(video_path);
-		if (!cap.IsOpened()) {
-			slog::err << "Cannot open the video" << slog::endl;
-			return 1;
+		// one pipeline per classroom, all of them feed the same sink queue
+		FrameQueue sink(queueSize * video_paths.size());
+		std::atomic<int> running(0);
+		std::vector<std::unique_ptr<ClassroomPipeline>> pipelines;
+		for (size_t i = 0; i < video_paths.size(); i++) {
+			pipelines.emplace_back(new ClassroomPipeline(i, sections[i], video_paths[i],
+					action_detector, face_detector, landmarks_detector, face_reid,
+					headPoseDetector, emotionsDetector, face_gallery,
+					tracker_reid_params, tracker_action_params, roster, timetable, queueSize, numRequests, cadences,
+					track_identity_params,
+					liveMode || video_paths[i] == "cam",
+					metrics, rollupWindows, sink, running));
+			if (!pipelines.back()->Open())
+				return 1;
 		}
 
-		if (cap.GrabNext()) {
-			cap.Retrieve(frame);
-		} else {
-			slog::err << "Can't read the first frame" << slog::endl;
-			return 1;
-		}
-
-		action_detector.enqueue(frame);
-		action_detector.submitRequest();
-		face_detector.enqueue(frame);
-		face_detector.submitRequest();
-		headPoseDetector.enqueue(frame);
-		headPoseDetector.submitRequest();
-		
-		prev_frame = frame.clone();
-
-		bool is_last_frame = false;
-		auto prev_frame_path = cap.GetVideoPath();
-
-		cv::VideoWriter vid_writer;
-		if (!FLAGS_out_v.empty()) {
-			vid_writer = cv::VideoWriter(FLAGS_out_v, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
-					cap.GetFPS(), Visualizer::GetOutputSize(frame.size()));
+		// per-classroom sink state, the visualizers keep references to the writers
+		std::vector<cv::VideoWriter> vid_writers(pipelines.size());
+		std::vector<std::unique_ptr<Visualizer>> visualizers;
+		std::vector<float> total_time_ms(pipelines.size(), 0.f);
+		std::vector<size_t> num_frames(pipelines.size(), 0);
+		std::vector<size_t> late_frames(pipelines.size(), 0);
+		// headless unless a window is requested, without a window and a writer nothing is rendered at all
+		const bool showWindows = noShow != 1 && !FLAGS_no_show;
+		for (size_t i = 0; i < pipelines.size(); i++) {
+			if (!FLAGS_out_v.empty()) {
+				std::string out_path = FLAGS_out_v;
+				if (pipelines.size() > 1)
+					out_path.insert(std::min(out_path.rfind('.'), out_path.size()), "_" + sections[i]);
+				vid_writers[i] = cv::VideoWriter(out_path, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+						pipelines[i]->GetFPS(), Visualizer::GetOutputSize(pipelines[i]->FrameSize()));
+			}
+			std::string window_name = "Classroom Analytics demo";
+			if (pipelines.size() > 1)
+				window_name += " - " + sections[i];
+			visualizers.emplace_back(new Visualizer(showWindows, vid_writers[i], window_name));
 		}
-		Visualizer sc_visualizer(!FLAGS_no_show, vid_writer);
 
-		if (!FLAGS_no_show) {
-			std::cout << "To close the application, press 'CTRL+C' or any key with focus on the output window" << std::endl;
+		if (showWindows) {
+			std::cout << "To close the application, press 'CTRL+C' or ESC with focus on the output window" << std::endl;
 		}
-		// open face model
-		net = readNet(model, config);
-		net.setPreferableBackend(backendId);
-		net.setPreferableTarget(targetId);
-
-		// open pose model
-		sentnet = readNet(sentmodel, sentconfig);
-		sentnet.setPreferableBackend(backendId);
-		sentnet.setPreferableTarget(targetId);
-
-		// open video capture source
-		// open pose model
-		posenet = readNet(posemodel, poseconfig);
-		posenet.setPreferableBackend(backendId);
-		posenet.setPreferableTarget(targetId);
-
-		// initialize classroom info
-		currentInfo.students = 0;
-		currentInfo.lookers = 0;
-		currentInfo.sent = {
-			{Neutral, 0},
-			{Happy, 0},
-			{Confused, 0},
-			{Surprised, 0},
-			{Anger, 0},
-			{Unknown, 0}
-		};
 
 		signal(SIGTERM, handle_sigterm);
-		// thread starts
-		thread t1(frameRunner);
-		thread t2(resetData);
-
-		while (!is_last_frame) {
-			auto started = std::chrono::high_resolution_clock::now();
-			is_last_frame = !cap.GrabNext();
-			if (is_last_frame && video_path != "cam") // Looping the videostream if-only-if it is a videofile.
-			{
-				if (cap.LoopVideo()){
-					is_last_frame = !cap.GrabNext();
-				}
-			}
-			if (!is_last_frame)
-				cap.Retrieve(frame);
-			getclassName();    
-			addImage(frame);
-
-			std::vector<std::string> students;
-			students = getStudentNames(fg_model_path);
-
-			sc_visualizer.SetFrame(prev_frame);
-			face_detector.wait();
-			face_detector.fetchResults();
-			faces = face_detector.results;
-
-			action_detector.wait();
-			action_detector.fetchResults();
-			actions = action_detector.results;
-
-			if (!is_last_frame) {
-				prev_frame_path = cap.GetVideoPath();
-				//cap.GetFrameIndex();
-				face_detector.enqueue(frame);
-				face_detector.submitRequest();
-				action_detector.enqueue(frame);
-				action_detector.submitRequest();
-			}
-			std::vector<cv::Mat> face_rois, landmarks, embeddings;
-			TrackedObjects tracked_face_objects;
-
-			for (const auto& face : faces) {
-				face_rois.push_back(prev_frame(face.rect));
-			}
-			landmarks_detector.Compute(face_rois, &landmarks, cv::Size(2, 5));
-			AlignFaces(&face_rois, &landmarks);
-			face_reid.Compute(face_rois, &embeddings);
-			auto ids = face_gallery.GetIDsByEmbeddings(embeddings);
-
-			for (size_t i = 0; i < faces.size(); i++) {
-				int label = ids.empty() ? EmbeddingsGallery::unknown_id : ids[i];
-				tracked_face_objects.emplace_back(faces[i].rect, faces[i].confidence, label);
+		signal(SIGINT, handle_sigterm);
+		for (auto& pipeline : pipelines)
+			pipeline->Start();
+
+		// sink stage: rendering and database writes for every analyzed frame of every classroom
+		// the sink is polled, so a signal stops the application also while no frame arrives
+		FrameDataPtr data;
+		while (true) {
+			if (sig_caught) {
+				cout << "Attempting to stop background threads" << endl;
+				break;
 			}
-			tracker_reid.Process(prev_frame, tracked_face_objects, num_frames);
-
-			const auto tracked_faces = tracker_reid.TrackedDetectionsWithLabels();
-
-			TrackedObjects tracked_action_objects;
-			for (const auto& action : actions) {
-				tracked_action_objects.emplace_back(action.rect, action.detection_conf, action.label);
+			if (!sink.PopFor(&data, std::chrono::milliseconds(100))) {
+				if (sink.Drained())
+					break;
+				continue;
 			}
+			const size_t stream = data->stream_idx;
+			if (pipelines[stream]->Stopped())
+				continue;
+			Visualizer& sc_visualizer = *visualizers[stream];
 
-			tracker_action.Process(prev_frame, tracked_action_objects, num_frames);
-			const auto tracked_actions = tracker_action.TrackedDetectionsWithLabels();
-
-			auto elapsed = std::chrono::high_resolution_clock::now() - started;
+			auto elapsed = std::chrono::high_resolution_clock::now() - data->started;
 			auto elapsed_ms =
 				std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
 
-			total_time_ms += elapsed_ms;
-			num_frames += 1;
-
-			std::map<int, int> frame_face_obj_id_to_action;
-			int participationCount=0; // standing count variable
-			captured.clear();
-			for (size_t j = 0; j < tracked_faces.size(); j++) 
-			{
-				const auto& face = tracked_faces[j];
-				std::string label_to_draw;
-				if (face.label != EmbeddingsGallery::unknown_id)
-				{
-					label_to_draw += face_gallery.GetLabelByID(face.label);
-					captured.push_back(label_to_draw);
-				}
-				label_to_draw =label_to_draw.substr(label_to_draw.find("_")+1);
-				sc_visualizer.DrawObject(face.rect, label_to_draw, green_color , white_color, true);
-
-				int person_ind = GetIndexOfTheNearestPerson(face, tracked_actions);
-				int action_ind = default_action_index;
-				if (person_ind >= 0) {
-					action_ind = tracked_actions[person_ind].label;
-				}
-
-				label_to_draw += "(" + GetActionTextLabel(action_ind) + ")";
-				frame_face_obj_id_to_action[face.object_id] = action_ind;
-
-				Participation = GetActionTextLabel(action_ind);
-				if((Participation == (char *)"standing")||(Participation == (char *)"raising_hand"))
-					participationCount++;
-				Participation.clear();
-				sc_visualizer.DrawObject(face.rect, label_to_draw, green_color, white_color, true);
-
+			total_time_ms[stream] += elapsed_ms;
+			num_frames[stream] += 1;
+			if (pipelines[stream]->Live() &&
+					std::chrono::steady_clock::now() - data->captured > latencyTarget) {
+				late_frames[stream] += 1;
 			}
 
-			face_obj_id_to_action_maps.push_back(frame_face_obj_id_to_action);
-
-			string label;
-			ClassroomInfo info = getCurrentInfo();
-
-			int attentiveStudents = 0, totalStudents = 0;
-
-			attentiveStudents = info.lookers;
-			totalStudents = info.students;
-
-			label = format("Students: %d,Neutral: %d,Happy: %d,Confused: %d,Surprised: %d,Anger: %d,Unknown: %d",
-					info.students, info.sent[Neutral], info.sent[Happy], info.sent[Confused],
-					info.sent[Surprised], info.sent[Anger], info.sent[Unknown]);
-			putText(frame, label, Point(0, 20), FONT_HERSHEY_COMPLEX, 0.5, Scalar(255,255, 255));
-			int nonLookers = info.students - info.lookers;
-			label = format("Attentive: %d, Non-Attentive: %d",
-					info.lookers, nonLookers);
-			putText(frame,label,Point(0,50),FONT_HERSHEY_COMPLEX, 0.5, Scalar(255,255,255));
-			totalEmotions= info.sent[Neutral] + info.sent[Happy] + info.sent[Confused] + info.sent[Surprised] + info.sent[Anger]
-				+ info.sent[Unknown];
-			happinessEmotions =  info.sent[Happy];
-			double happinessIndex = 0, attentiveIndex = 0,participationIndex = 0;
+			const ClassroomInfo& info = data->info;
+			if (sc_visualizer.Active()) {
+				sc_visualizer.SetFrame(data->frame);
+				for (size_t j = 0; j < data->tracked_faces.size(); j++) {
+					sc_visualizer.DrawObject(data->tracked_faces[j].rect, data->face_labels[j], green_color, white_color, true);
+				}
 
-			Mat nex = nextImageAvailable();
-			if (nex.empty()) { 
+				string label;
+				label = format("Students: %d,Neutral: %d,Happy: %d,Confused: %d,Surprised: %d,Anger: %d,Unknown: %d",
+						info.students, info.sent.at(Neutral), info.sent.at(Happy), info.sent.at(Confused),
+						info.sent.at(Surprised), info.sent.at(Anger), info.sent.at(Unknown));
+				sc_visualizer.DrawText(label, Point(0, 20));
+				int nonLookers = info.students - info.lookers;
+				label = format("Attentive: %d, Non-Attentive: %d",
+						info.lookers, nonLookers);
+				sc_visualizer.DrawText(label, Point(0, 50));
 				if (info.students > 0) {
-					happinessIndex = happinessCal(totalEmotions,happinessEmotions);
-					attentiveIndex = attentiveCal(totalStudents,attentiveStudents);
-					participationIndex = participationCal(participationCount,info.students);
-					label = format("Attentivity Index: %.2f", attentiveIndex);
-					putText(frame,label,Point(0,80),FONT_HERSHEY_COMPLEX, 0.5, Scalar(255, 255, 255),1);
-					label = format("Happiness Index: %.2f", happinessIndex);
-					putText(frame,label,Point(0,110),FONT_HERSHEY_COMPLEX, 0.5, Scalar(255,255,255));
-					label = format("Participation Index: %.2f", participationIndex);
-					putText(frame,label,Point(0,140),FONT_HERSHEY_COMPLEX, 0.5, Scalar(255,255,255));
+					label = format("Attentivity Index: %.2f", data->attentive_index);
+					sc_visualizer.DrawText(label, Point(0, 80));
+					label = format("Happiness Index: %.2f", data->happiness_index);
+					sc_visualizer.DrawText(label, Point(0, 110));
+					label = format("Participation Index: %.2f", data->participation_index);
+					sc_visualizer.DrawText(label, Point(0, 140));
+				}
+				if (pipelines[stream]->Live()) {
+					label = format("Dropped frames: %d, Late frames: %d",
+							static_cast<int>(pipelines[stream]->DroppedFrames()), static_cast<int>(late_frames[stream]));
+					sc_visualizer.DrawText(label, Point(0, 170));
 				}
 			}
-			if (waitKey(delay) == 27 || sig_caught) {
-				cout << "Attempting to stop background threads" << endl;
-				keepRunning = false;
-				break;
-			}
-
-			if(subject.length()==0)	
-				subject = "No_Time_Assigned";
-
-			//Inserting data in to infuxdb
-			if (info.students != 0) // No need to insert data if students strength is '0'.
-			{
-				std::string commonPath = "curl -i -XPOST 'http://" + influxdbIp +":8086/write?db=Analytics' --data-binary '" + classSection;
-
-				std::string classData = commonPath +',' + "classname="+ subject + " " + "studentpresent="+ std::to_string(info.students) + ',' +"participation=" + std::to_string(participationIndex) + ','+ "happiness=" + std::to_string(happinessIndex) +','+"attentivity=" + std::to_string(attentiveIndex) +"'" +" >/dev/null 2>&1";
-				int  writeStatus = system(classData.c_str());
-				if (writeStatus != 0) {
-					std::cout <<"Failed to insert data in DB : ret val" << writeStatus << std::endl;
-					classData.clear();
-					exit(0);
-				}  
-				classData.clear();
-				commonPath.clear();
-			}
-			// For Finding Faces 
-			std::string str;
-			int i=0,j=0;
-
-			std::time_t t_old = std::time(0);   // get time now
-			std::tm* now_old = std::localtime(&t_old);
-			int hour = now_old->tm_hour;
-			int sec = now_old->tm_sec;
-			int min=now_old->tm_min;
-			stringstream stringtoInt(checkTime);
-			int intString = 0;
-			stringtoInt >> intString;
-			if(intString == hour && min==30 && (sec == 1 || sec == 2)) {
-				// Inserting absent List into Database for every one hour
-				std::string studentName;
-				for (const auto &name : students) {
-					studentName = name;
-					i=0,j=0;
-					while(i < static_cast<int>(captured.size())) {
-						if(studentName == captured[i]) {
-							j++;
-							break;
-						}
-						i++;
-					}
-					if(j==0) {
-						std::string name = studentName.substr(3);
-						std::string commonPath = "curl -i -XPOST 'http://" + influxdbIp +":8086/write?db=Analytics' --data-binary 'AbsentList,";
-						std::string absentBuffer = commonPath + "subjectName=" + subject+','+  "section="+ classSection +" " + "absentName=" +"\"" + name + "\"" + "'" +" >/dev/null 2>&1";
-						int  writeStatus = system(absentBuffer.c_str());
-						if (writeStatus != 0) {
-							std::cout <<"Failed to insert absenties data in DB : ret val" << writeStatus << std::endl;
-							absentBuffer.clear();
-							exit(0);
-						} 
-						absentBuffer.clear();
-						commonPath.clear();
-					}
-				}	
-			}
-			students.clear(); 
-			attentiveStudents = totalStudents = totalEmotions = happinessEmotions = 0;
-			if(noShow!=1)
+			if (sc_visualizer.Active())
 				sc_visualizer.Show();
-			char key = cv::waitKey(1);
-			if (key == ESC_KEY) {
+			// the GUI event loop is pumped only when there are windows to serve
+			if (showWindows && cv::waitKey(delay) == ESC_KEY) {
+				cout << "Attempting to stop background threads" << endl;
 				break;
 			}
-			if (FLAGS_last_frame >= 0 && num_frames > static_cast<size_t>(FLAGS_last_frame)) {
-				break;
+			if (FLAGS_last_frame >= 0 && num_frames[stream] > static_cast<size_t>(FLAGS_last_frame)) {
+				pipelines[stream]->Stop();
 			}
-			prev_frame = frame.clone();
 		}
-		t1.join(); 
-		t2.join();
-		sc_visualizer.Finalize();
+		keepRunning = false;
+		sink.Close();
+		for (auto& pipeline : pipelines)
+			pipeline->Stop();
+		for (auto& pipeline : pipelines)
+			pipeline->Join();
+		metrics.Close();
+		slog::info << "Points written to the database: " << metrics.Written() << ", spooled: " << metrics.Spooled()
+			<< ", dropped: " << metrics.Dropped() << slog::endl;
+		for (auto& visualizer : visualizers)
+			visualizer->Finalize();
 		slog::info << slog::endl;
+		for (size_t i = 0; i < pipelines.size(); i++) {
+			if (pipelines[i]->Live()) {
+				slog::info << "Section " << sections[i] << ": " << num_frames[i] << " frames processed, "
+					<< pipelines[i]->DroppedFrames() << " dropped, " << late_frames[i]
+					<< " later than " << latencyTarget.count() << " ms" << slog::endl;
+			}
+		}
 
 		if (FLAGS_pc) {
 			std::map<std::string, std::string>  mapDevices = getMapFullDevicesNames(ie, devices);
-			face_detector.wait();
-			action_detector.wait();
-			action_detector.PrintPerformanceCounts(getFullDeviceName(mapDevices, d_act));
-			face_detector.PrintPerformanceCounts(getFullDeviceName(mapDevices, d_fd));
+			for (auto& pipeline : pipelines)
+				pipeline->PrintPerformanceCounts(getFullDeviceName(mapDevices, d_act),
+						getFullDeviceName(mapDevices, d_fd));
 			face_reid.PrintPerformanceCounts(getFullDeviceName(mapDevices, d_reid));
 			landmarks_detector.PrintPerformanceCounts(getFullDeviceName(mapDevices, d_lm));
 		}
-		auto face_tracks = tracker_reid.vector_tracks();
-		// correct labels for track
-		std::vector<Track> new_face_tracks = UpdateTrackLabelsToBestAndFilterOutUnknowns(face_tracks);
-		std::map<int, int> face_track_id_to_label = GetMapFaceTrackIdToLabel(new_face_tracks);
-
 		DetectionsLogger logger(std::cout, FLAGS_r, FLAGS_ad);
-		logger.DumpDetections(cap.GetVideoPath(), frame.size(), num_frames,
-				new_face_tracks,
-				face_track_id_to_label,
-				actions_map, face_gallery.GetIDToLabelMap(),
-				face_obj_id_to_action_maps);  
+		for (size_t i = 0; i < pipelines.size(); i++) {
+			auto face_tracks = pipelines[i]->FaceTracker().vector_tracks();
+			// correct labels for track
+			std::vector<Track> new_face_tracks = UpdateTrackLabelsToBestAndFilterOutUnknowns(face_tracks);
+			std::map<int, int> face_track_id_to_label = GetMapFaceTrackIdToLabel(new_face_tracks);
+
+			logger.DumpDetections(pipelines[i]->GetVideoPath(), pipelines[i]->FrameSize(), num_frames[i],
+					new_face_tracks,
+					face_track_id_to_label,
+					actions_map, face_gallery.Current()->GetIDToLabelMap(),
+					pipelines[i]->FaceObjIdToActionMaps());  
+		}
 	}
 	catch (const std::exception& error) {
 		slog::err << error.what() << slog::endl;
@@ -10,16 +10,29 @@
 #include <vector>
 #include <string>
 #include <limits>
+#include <algorithm>
+#include <iterator>
 
 #include <opencv2/opencv.hpp>
 
 namespace {
-    float ComputeReidDistance(const cv::Mat& descr1, const cv::Mat& descr2) {
-        float xy = descr1.dot(descr2);
-        float xx = descr1.dot(descr1);
-        float yy = descr2.dot(descr2);
-        float norm = sqrt(xx * yy) + 1e-6;
-        return 1.0f - xy / norm;
+    // Stacks the vectors into the rows of one matrix, each row scaled to unit length
+    cv::Mat NormalizedRows(const std::vector<cv::Mat>& vectors) {
+        cv::Mat rows(static_cast<int>(vectors.size()), static_cast<int>(vectors[0].total()), CV_32F);
+        for (int i = 0; i < rows.rows; i++) {
+            cv::Mat row = rows.row(i);
+            vectors[i].reshape(1, 1).convertTo(row, CV_32F);
+            cv::normalize(row, row);
+        }
+        return rows;
+    }
+
+    bool read_file(const std::string& name, std::vector<uchar>* bytes) {
+        std::ifstream f(name.c_str(), std::ios::binary);
+        if (!f.good())
+            return false;
+        bytes->assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        return true;
     }
 
     bool file_exists(const std::string& name) {
@@ -43,6 +56,12 @@ namespace {
         return std::string(".") + separator();
     }
 
+    // references an index returns per face at least, exactly ranked
+    const size_t min_index_candidates = 32;
+
+    // quantized embeddings that agree less often with fp32 on the nearest image are not used
+    const double min_quantized_recall = 0.99;
+
 }  // namespace
 
 const std::string EmbeddingsGallery::unknown_label = "Unknown";
@@ -51,7 +70,11 @@ const int EmbeddingsGallery::unknown_id = TrackedObject::UNKNOWN_LABEL_IDX;
 EmbeddingsGallery::EmbeddingsGallery(const std::string& ids_list,
                                      double threshold,
                                      const VectorCNN& landmarks_det,
-                                     const VectorCNN& image_reid)
+                                     const VectorCNN& image_reid,
+                                     EmbeddingCache* cache,
+                                     const EmbeddingsGallery* previous,
+                                     const std::string& index_type,
+                                     const std::string& precision)
     : reid_threshold(threshold) {
     if (ids_list.empty()) {
         std::cout << "Warning: face reid gallery is empty!" << "\n";
@@ -65,35 +88,133 @@ EmbeddingsGallery::EmbeddingsGallery(const std::string& ids_list,
 
     cv::FileStorage fs(ids_list, cv::FileStorage::Mode::READ);
     cv::FileNode fn = fs.root();
-    int total_images = 0;
-    int id = 0;
+    // identities keep the ids they had in the previous gallery, new ones are appended
+    std::vector<std::string> labels;
+    std::map<std::string, int> label_to_id;
+    if (previous) {
+        labels = previous->GetIDToLabelMap();
+        for (size_t id = 0; id < labels.size(); id++)
+            label_to_id[labels[id]] = static_cast<int>(id);
+    }
+    std::vector<bool> enrolled(labels.size(), false);
+    std::vector<std::string>& paths = image_paths;
+    std::vector<int> owners;
     for (cv::FileNodeIterator fit = fn.begin(); fit != fn.end(); ++fit) {
         cv::FileNode item = *fit;
-        std::string label = item.name();
-        std::vector<cv::Mat> embeddings;
-
+        auto known = label_to_id.find(item.name());
+        int id = static_cast<int>(labels.size());
+        if (known != label_to_id.end()) {
+            id = known->second;
+        } else {
+            label_to_id[item.name()] = id;
+            labels.push_back(item.name());
+            enrolled.push_back(false);
+        }
+        enrolled[id] = true;
         for (size_t i = 0; i < item.size(); i++) {
-            std::string path;
             if (file_exists(item[i].string())) {
-                path = item[i].string();
+                paths.push_back(item[i].string());
+            } else {
+                paths.push_back(folder_name(ids_list) + separator() + item[i].string());
+            }
+            owners.push_back(id);
+        }
+    }
+
+    // the cache keeps only the images of this build
+    if (cache)
+        cache->BeginBuild();
+
+    // Images are read, hashed and decoded on all cores and go through the
+    // networks in full batches, a chunk at a time to bound the memory held.
+    const int chunk_size = 128;
+    const int total_images = static_cast<int>(paths.size());
+    int cached_images = 0;
+    std::vector<cv::Mat> all_embeddings(paths.size());
+    for (int chunk_begin = 0; chunk_begin < total_images; chunk_begin += chunk_size) {
+        const int chunk_end = std::min(total_images, chunk_begin + chunk_size);
+        std::vector<std::vector<uchar>> bytes(chunk_end - chunk_begin);
+        std::vector<uint64_t> keys(bytes.size());
+        std::vector<uchar> ok(bytes.size(), 0);
+        cv::parallel_for_(cv::Range(chunk_begin, chunk_end), [&](const cv::Range& range) {
+            for (int i = range.start; i < range.end; i++) {
+                const int k = i - chunk_begin;
+                ok[k] = read_file(paths[i], &bytes[k]);
+                keys[k] = HashBytes(bytes[k].data(), bytes[k].size());
+            }
+        });
+
+        // unchanged images are not embedded again
+        std::vector<int> missing;
+        for (int i = chunk_begin; i < chunk_end; i++) {
+            const int k = i - chunk_begin;
+            CV_Assert(ok[k]);
+            if (cache && cache->Find(keys[k], &all_embeddings[i])) {
+                cached_images++;
             } else {
-                path = folder_name(ids_list) + separator() + item[i].string();
+                missing.push_back(i);
             }
+        }
+        if (missing.empty())
+            continue;
 
-            cv::Mat image = cv::imread(path);
+        std::vector<cv::Mat> images(missing.size());
+        cv::parallel_for_(cv::Range(0, static_cast<int>(missing.size())), [&](const cv::Range& range) {
+            for (int m = range.start; m < range.end; m++) {
+                images[m] = cv::imdecode(bytes[missing[m] - chunk_begin], cv::IMREAD_COLOR);
+            }
+        });
+        for (const auto& image : images)
             CV_Assert(!image.empty());
-            cv::Mat emb, landmarks;
-            landmarks_det.Compute(image, &landmarks, cv::Size(2, 5));
-            std::vector<cv::Mat> images = {image};
-            std::vector<cv::Mat> landmarks_vec = {landmarks};
-            AlignFaces(&images, &landmarks_vec);
-            image_reid.Compute(images[0], &emb);
-            embeddings.push_back(emb);
-            idx_to_id.push_back(total_images);
-            total_images++;
+
+        std::vector<cv::Mat> landmarks, embeddings;
+        landmarks_det.Compute(images, &landmarks, cv::Size(2, 5));
+        AlignFaces(&images, &landmarks);
+        image_reid.Compute(images, &embeddings);
+        for (size_t m = 0; m < missing.size(); m++) {
+            all_embeddings[missing[m]] = embeddings[m];
+            if (cache)
+                cache->Add(keys[missing[m] - chunk_begin], embeddings[m]);
         }
-        identities.emplace_back(embeddings, label, id);
-        ++id;
+    }
+
+    std::vector<std::vector<cv::Mat>> embeddings(labels.size());
+    for (int i = 0; i < total_images; i++) {
+        embeddings[owners[i]].push_back(all_embeddings[i]);
+    }
+    // distance columns run over the embeddings of the identities in id order
+    std::vector<cv::Mat> references;
+    references.reserve(all_embeddings.size());
+    for (size_t id = 0; id < labels.size(); id++) {
+        identities.emplace_back(embeddings[id].size(), labels[id], static_cast<int>(id), enrolled[id]);
+        max_identity_images = std::max(max_identity_images, embeddings[id].size());
+        idx_to_id.insert(idx_to_id.end(), embeddings[id].size(), static_cast<int>(id));
+        references.insert(references.end(), embeddings[id].begin(), embeddings[id].end());
+    }
+    EmbeddingPrecision storage;
+    CV_Assert(ParseEmbeddingPrecision(precision, &storage));
+    if (!references.empty()) {
+        cv::Mat rows = NormalizedRows(references);
+        index = CreateGalleryIndex(index_type, rows);
+        // an index keeps the rows it searches itself
+        if (!index) {
+            reference_matrix = EmbeddingMatrix(rows, storage);
+            if (storage != EmbeddingPrecision::FP32) {
+                double recall = NearestNeighbourRecall(rows, reference_matrix);
+                std::cout << "Face gallery: " << EmbeddingPrecisionName(storage) << " embeddings keep "
+                          << recall * 100 << "% of the fp32 nearest neighbours" << "\n";
+                if (recall < min_quantized_recall) {
+                    std::cout << "Warning: falling back to fp32 face gallery embeddings" << "\n";
+                    reference_matrix = EmbeddingMatrix(rows, EmbeddingPrecision::FP32);
+                }
+            }
+        }
+    }
+    if (cache) {
+        std::cout << "Face gallery: " << cached_images << " of " << total_images
+                  << " embeddings read from the cache" << "\n";
+        if (cache->Changed())
+            cache->Save();
     }
 }
 
@@ -101,25 +222,71 @@ std::vector<int> EmbeddingsGallery::GetIDsByEmbeddings(const std::vector<cv::Mat
     if (embeddings.empty() || idx_to_id.empty())
         return std::vector<int>();
 
-    cv::Mat distances(static_cast<int>(embeddings.size()), static_cast<int>(idx_to_id.size()), CV_32F);
+    // the distance of a face to an identity is the one to its closest image,
+    // identities without candidates or images are as far as they can be
+    cv::Mat queries = NormalizedRows(embeddings);
+    cv::Mat identity_distances(queries.rows, static_cast<int>(identities.size()), CV_32F, cv::Scalar(2.0f));
+    auto reduce = [&identity_distances, this](int face, int reference, float similarity) {
+        float& distance = identity_distances.at<float>(face, idx_to_id[reference]);
+        distance = std::min(distance, std::max(0.0f, 1.0f - similarity));
+    };
+    if (index) {
+        // the closest n images may all be of one identity, the n closest identities
+        // of a face are only among its candidates with n times the most images per identity
+        const size_t num_candidates = std::max(min_index_candidates, embeddings.size() * max_identity_images);
+        std::vector<std::vector<GalleryCandidate>> candidates;
+        index->Search(queries, num_candidates, &candidates);
+        for (int i = 0; i < queries.rows; i++) {
+            for (const auto& candidate : candidates[i])
+                reduce(i, candidate.row, candidate.similarity);
+        }
+    } else {
+        // with unit length rows the similarities of all pairs come from one matrix product
+        cv::Mat similarities;
+        reference_matrix.Similarities(queries, &similarities);
+        for (int i = 0; i < similarities.rows; i++) {
+            const float* row = similarities.ptr<float>(i);
+            for (int k = 0; k < similarities.cols; k++)
+                reduce(i, k, row[k]);
+        }
+    }
 
-    for (int i = 0; i < distances.rows; i++) {
-        int k = 0;
-        for (size_t j = 0; j < identities.size(); j++) {
-            for (const auto& reference_emb : identities[j].embeddings) {
-                distances.at<float>(i, k) = ComputeReidDistance(embeddings[i], reference_emb);
-                k++;
+    // An optimal assignment of n faces only ever uses the n closest identities
+    // of every face, so the other identities are dropped before matching.
+    const size_t k = embeddings.size();
+    std::vector<int> columns;
+    std::vector<char> kept(identities.size(), 0);
+    std::vector<int> order;
+    for (size_t id = 0; id < identities.size(); id++) {
+        if (identities[id].num_embeddings != 0)
+            order.push_back(static_cast<int>(id));
+    }
+    for (int i = 0; i < identity_distances.rows; i++) {
+        const float* row = identity_distances.ptr<float>(i);
+        const size_t top = std::min(k, order.size());
+        std::partial_sort(order.begin(), order.begin() + top, order.end(),
+                          [row](int a, int b) { return row[a] < row[b]; });
+        for (size_t j = 0; j < top; j++) {
+            if (!kept[order[j]]) {
+                kept[order[j]] = 1;
+                columns.push_back(order[j]);
             }
         }
     }
+    cv::Mat distances(identity_distances.rows, static_cast<int>(columns.size()), CV_32F);
+    for (int c = 0; c < distances.cols; c++)
+        identity_distances.col(columns[c]).copyTo(distances.col(c));
+
     KuhnMunkres matcher;
     auto matched_idx = matcher.Solve(distances);
     std::vector<int> output_ids;
     for (auto col_idx : matched_idx) {
-        if (distances.at<float>(output_ids.size(), col_idx) > reid_threshold)
+        // with more faces than identities some faces are matched to padding
+        if (col_idx >= columns.size() ||
+            distances.at<float>(static_cast<int>(output_ids.size()), static_cast<int>(col_idx)) > reid_threshold)
             output_ids.push_back(unknown_id);
         else
-            output_ids.push_back(idx_to_id[col_idx]);
+            output_ids.push_back(columns[col_idx]);
     }
     return output_ids;
 }
@@ -131,6 +298,16 @@ std::string EmbeddingsGallery::GetLabelByID(int id) const {
         return unknown_label;
 }
 
+bool EmbeddingsGallery::IsEnrolled(int id) const {
+    // a label without embeddings can never be recognized, it would always be reported absent
+    return id >= 0 && id < static_cast<int>(identities.size()) && identities[id].enrolled &&
+           identities[id].num_embeddings != 0;
+}
+
+const std::vector<std::string>& EmbeddingsGallery::GetImagePaths() const {
+    return image_paths;
+}
+
 size_t EmbeddingsGallery::size() const {
     return identities.size();
 }
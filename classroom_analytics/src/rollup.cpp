@@ -0,0 +1,117 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "rollup.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+long long ToMilliseconds(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+}  // anonymous namespace
+
+WindowedRollup::WindowedRollup(const std::string& measurement, const std::vector<std::chrono::seconds>& windows)
+    : measurement_(measurement) {
+    for (const auto& window : windows) {
+        if (window.count() > 0) {
+            windows_.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(window).count());
+        }
+    }
+    std::sort(windows_.begin(), windows_.end());
+    windows_.erase(std::unique(windows_.begin(), windows_.end()), windows_.end());
+}
+
+void WindowedRollup::Add(const Tags& tags, const Fields& fields, std::chrono::system_clock::time_point time,
+                         std::vector<LinePoint>* points) {
+    if (windows_.empty()) {
+        return;
+    }
+    std::string key;
+    for (const auto& tag : tags) {
+        key += tag.first + '=' + tag.second + ',';
+    }
+    Series& series = series_[key];
+    if (series.windows.empty()) {
+        series.tags = tags;
+        series.windows.resize(windows_.size(), Window{0, 0, {}});
+    }
+
+    const long long time_ms = ToMilliseconds(time);
+    for (size_t i = 0; i < windows_.size(); i++) {
+        Window& window = series.windows[i];
+        const long long start_ms = time_ms - time_ms % windows_[i];
+        if (window.samples > 0 && window.start_ms != start_ms) {
+            Emit(series, i, points);
+            window.samples = 0;
+            window.fields.clear();
+        }
+        window.start_ms = start_ms;
+        window.samples++;
+        for (const auto& field : fields) {
+            auto stats = window.fields.find(field.first);
+            if (stats == window.fields.end()) {
+                window.fields[field.first] = Stats{field.second, field.second, field.second, field.second, 1};
+            } else {
+                stats->second.min = std::min(stats->second.min, field.second);
+                stats->second.max = std::max(stats->second.max, field.second);
+                stats->second.sum += field.second;
+                stats->second.last = field.second;
+                stats->second.count++;
+            }
+        }
+    }
+}
+
+void WindowedRollup::Flush(std::chrono::system_clock::time_point time, std::vector<LinePoint>* points) {
+    const long long time_ms = ToMilliseconds(time);
+    for (auto it = series_.begin(); it != series_.end();) {
+        bool open = false;
+        for (size_t i = 0; i < windows_.size(); i++) {
+            Window& window = it->second.windows[i];
+            if (window.samples > 0 && window.start_ms + windows_[i] <= time_ms) {
+                Emit(it->second, i, points);
+                window.samples = 0;
+                window.fields.clear();
+            }
+            open = open || window.samples > 0;
+        }
+        // a series that stopped, e.g. after the subject changed, is forgotten
+        it = open ? std::next(it) : series_.erase(it);
+    }
+}
+
+void WindowedRollup::FlushAll(std::vector<LinePoint>* points) {
+    for (const auto& series : series_) {
+        for (size_t i = 0; i < windows_.size(); i++) {
+            if (series.second.windows[i].samples > 0) {
+                Emit(series.second, i, points);
+            }
+        }
+    }
+    series_.clear();
+}
+
+void WindowedRollup::Emit(const Series& series, size_t window_idx, std::vector<LinePoint>* points) const {
+    const Window& window = series.windows[window_idx];
+    LinePoint point(measurement_);
+    for (const auto& tag : series.tags) {
+        point.Tag(tag.first, tag.second);
+    }
+    point.Tag("window", std::to_string(windows_[window_idx] / 1000) + "s");
+    for (const auto& field : window.fields) {
+        point.Field(field.first, field.second.sum / field.second.count)
+             .Field(field.first + "_min", field.second.min)
+             .Field(field.first + "_max", field.second.max)
+             .Field(field.first + "_last", field.second.last);
+    }
+    point.Field("samples", static_cast<double>(window.samples))
+         .Time(std::chrono::system_clock::time_point(std::chrono::milliseconds(window.start_ms)));
+    points->push_back(point);
+}
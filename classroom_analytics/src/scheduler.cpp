@@ -0,0 +1,33 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "scheduler.hpp"
+
+#include <algorithm>
+
+Cadence::Cadence(int interval, bool adaptive)
+    : base_interval_(std::max(interval, 1)), interval_(std::max(interval, 1)), adaptive_(adaptive),
+      has_run_(false), last_run_(0), has_feedback_(false), last_num_objects_(0) {}
+
+bool Cadence::ShouldRun(size_t frame_idx) {
+    if (has_run_ && frame_idx < last_run_ + interval_) {
+        return false;
+    }
+    has_run_ = true;
+    last_run_ = frame_idx;
+    return true;
+}
+
+void Cadence::Feedback(size_t num_objects) {
+    if (!adaptive_) {
+        return;
+    }
+    if (has_feedback_ && num_objects == last_num_objects_) {
+        interval_ = std::min(interval_ + 1, base_interval_ * max_factor);
+    } else {
+        interval_ = base_interval_;
+    }
+    has_feedback_ = true;
+    last_num_objects_ = num_objects;
+}
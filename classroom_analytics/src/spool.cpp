@@ -0,0 +1,190 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "spool.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace {
+
+const char segment_prefix[] = "segment-";
+const char segment_suffix[] = ".log";
+const char offset_file[] = "offset";
+
+}  // anonymous namespace
+
+LineSpool::LineSpool(const std::string& directory, size_t segment_bytes, size_t max_segments)
+    : directory_(directory), segment_bytes_(std::max<size_t>(segment_bytes, 1)),
+      max_segments_(std::max<size_t>(max_segments, 2)), next_id_(0), writing_(false),
+      read_offset_(0), next_offset_(0), dropped_segments_(0) {}
+
+std::string LineSpool::SegmentPath(unsigned long long id) const {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s%020llu%s", segment_prefix, id, segment_suffix);
+    return directory_ + "/" + name;
+}
+
+bool LineSpool::Open() {
+    if (mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) {
+        return false;
+    }
+    DIR* dir = opendir(directory_.c_str());
+    if (dir == nullptr) {
+        return false;
+    }
+    const std::string prefix = segment_prefix;
+    const std::string suffix = segment_suffix;
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        unsigned long long id = std::strtoull(name.c_str() + prefix.size(), nullptr, 10);
+        struct stat info;
+        if (stat(SegmentPath(id).c_str(), &info) == 0) {
+            segments_.push_back({id, static_cast<size_t>(info.st_size)});
+        }
+    }
+    closedir(dir);
+    std::sort(segments_.begin(), segments_.end(),
+              [](const Segment& a, const Segment& b) { return a.id < b.id; });
+    if (!segments_.empty()) {
+        next_id_ = segments_.back().id + 1;
+    }
+
+    // segments older than the saved read position have been consumed already
+    unsigned long long saved_id = 0;
+    size_t saved_offset = 0;
+    std::ifstream offset(directory_ + "/" + offset_file);
+    if (offset >> saved_id >> saved_offset) {
+        while (!segments_.empty() && segments_.front().id < saved_id) {
+            RemoveFront();
+        }
+        if (!segments_.empty() && segments_.front().id == saved_id) {
+            read_offset_ = next_offset_ = std::min(saved_offset, segments_.front().size);
+        }
+        next_id_ = std::max(next_id_, saved_id + 1);
+    }
+    return true;
+}
+
+bool LineSpool::StartSegment() {
+    writer_.close();
+    writer_.clear();
+    writer_.open(SegmentPath(next_id_), std::ios::binary | std::ios::app);
+    if (!writer_.is_open()) {
+        writing_ = false;
+        return false;
+    }
+    segments_.push_back({next_id_++, 0});
+    writing_ = true;
+    while (segments_.size() > max_segments_) {
+        RemoveFront();
+        ++dropped_segments_;
+    }
+    return true;
+}
+
+bool LineSpool::Append(std::vector<std::string>::const_iterator begin,
+                       std::vector<std::string>::const_iterator end) {
+    if (begin == end) {
+        return true;
+    }
+    if ((!writing_ || segments_.back().size >= segment_bytes_) && !StartSegment()) {
+        return false;
+    }
+    size_t size = 0;
+    for (auto line = begin; line != end; ++line) {
+        writer_ << *line << '\n';
+        size += line->size() + 1;
+    }
+    writer_.flush();
+    if (!writer_.good()) {
+        // whatever made it to the file stays unaccounted, the next append starts a new segment
+        writing_ = false;
+        return false;
+    }
+    segments_.back().size += size;
+    return true;
+}
+
+bool LineSpool::Read(size_t max_lines, std::vector<std::string>* lines) {
+    lines->clear();
+    while (!segments_.empty()) {
+        const Segment& segment = segments_.front();
+        if (read_offset_ >= segment.size) {
+            if (segments_.size() == 1) {
+                return false;
+            }
+            RemoveFront();
+            continue;
+        }
+
+        std::ifstream in(SegmentPath(segment.id), std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(read_offset_));
+        size_t offset = read_offset_;
+        std::string line;
+        while (lines->size() < max_lines && offset < segment.size && std::getline(in, line)) {
+            if (offset + line.size() + 1 > segment.size) {
+                // a line cut short by a crash
+                offset = segment.size;
+                break;
+            }
+            offset += line.size() + 1;
+            if (!line.empty()) {
+                lines->push_back(line);
+            }
+        }
+        if (offset == read_offset_) {
+            // the segment cannot be read anymore
+            offset = segment.size;
+        }
+        next_offset_ = offset;
+        if (!lines->empty()) {
+            return true;
+        }
+        Commit();
+    }
+    return false;
+}
+
+void LineSpool::Commit() {
+    if (segments_.empty()) {
+        return;
+    }
+    read_offset_ = next_offset_;
+    if (read_offset_ >= segments_.front().size) {
+        if (segments_.size() == 1 && writing_) {
+            writer_.close();
+            writing_ = false;
+        }
+        RemoveFront();
+    }
+    SaveOffset();
+}
+
+bool LineSpool::Empty() const {
+    return segments_.empty() || (segments_.size() == 1 && read_offset_ >= segments_.front().size);
+}
+
+void LineSpool::RemoveFront() {
+    std::remove(SegmentPath(segments_.front().id).c_str());
+    segments_.pop_front();
+    read_offset_ = next_offset_ = 0;
+}
+
+void LineSpool::SaveOffset() {
+    std::ofstream offset(directory_ + "/" + offset_file, std::ios::trunc);
+    offset << (segments_.empty() ? next_id_ : segments_.front().id) << ' ' << read_offset_ << '\n';
+}
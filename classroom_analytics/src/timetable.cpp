@@ -0,0 +1,188 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "timetable.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+
+#include <samples/slog.hpp>
+
+namespace {
+
+const int minutes_per_day = 24 * 60;
+const int minutes_per_week = 7 * minutes_per_day;
+
+// Parses "H" or "HH:MM" into minutes since midnight, 24:00 is accepted as an end of day
+bool ParseTime(const std::string& text, bool end_of_day, int* minutes) {
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) {
+        return false;
+    }
+    char* rest = nullptr;
+    long hour = std::strtol(text.c_str(), &rest, 10);
+    long minute = 0;
+    if (*rest == ':') {
+        const char* minute_text = rest + 1;
+        minute = std::strtol(minute_text, &rest, 10);
+        if (rest == minute_text) {
+            return false;
+        }
+    }
+    if (*rest != '\0' || hour < 0 || minute < 0 || minute > 59 ||
+        (hour > 23 && !(end_of_day && hour == 24 && minute == 0))) {
+        return false;
+    }
+    *minutes = static_cast<int>(hour * 60 + minute);
+    return true;
+}
+
+// Parses "Mon,Wed,Fri" into week day indices, Monday is 0
+bool ParseDays(const std::string& text, std::vector<int>* days) {
+    static const char* const names[] = {"mon", "tue", "wed", "thu", "fri", "sat", "sun"};
+    std::vector<std::string> items;
+    boost::split(items, text, boost::is_any_of(","));
+    days->clear();
+    for (auto& item : items) {
+        boost::trim(item);
+        std::string name = boost::to_lower_copy(item.substr(0, 3));
+        auto day = std::find(std::begin(names), std::end(names), name);
+        if (item.size() < 3 || day == std::end(names)) {
+            return false;
+        }
+        days->push_back(static_cast<int>(day - std::begin(names)));
+    }
+    return !days->empty();
+}
+
+}  // anonymous namespace
+
+Timetable::Timetable(const std::string& path, std::chrono::seconds check_interval)
+    : path_(path), check_interval_(check_interval), checked_(false), missing_(false),
+      cached_(false), cached_slot_(-1) {}
+
+bool Timetable::Load() {
+    std::ifstream in(path_);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::vector<TimetableSlot> slots;
+    size_t skipped = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        boost::trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> parts;
+        boost::split(parts, line, boost::is_any_of("-"));
+        for (auto& part : parts) {
+            boost::trim(part);
+        }
+
+        int start = 0;
+        int end = 0;
+        std::vector<int> days = {0, 1, 2, 3, 4, 5, 6};
+        bool valid = parts.size() >= 2 && parts.size() <= 4 && !parts[0].empty() &&
+                     ParseTime(parts[1], false, &start);
+        if (valid && parts.size() == 2) {
+            // the original format names the hour only
+            valid = parts[1].find(':') == std::string::npos;
+            end = start + 60;
+        } else if (valid) {
+            valid = ParseTime(parts[2], true, &end) && (parts.size() < 4 || ParseDays(parts[3], &days));
+        }
+        if (!valid) {
+            ++skipped;
+            continue;
+        }
+        if (end <= start) {
+            // the class goes on past midnight
+            end += minutes_per_day;
+        }
+        for (int day : days) {
+            TimetableSlot slot = {parts[0], day * minutes_per_day + start, day * minutes_per_day + end};
+            if (slot.end > minutes_per_week) {
+                slots.push_back({slot.subject, 0, slot.end - minutes_per_week});
+                slot.end = minutes_per_week;
+            }
+            slots.push_back(slot);
+        }
+    }
+    std::sort(slots.begin(), slots.end(),
+              [](const TimetableSlot& a, const TimetableSlot& b) { return a.start < b.start; });
+    slots_.swap(slots);
+    slog::info << "Loaded " << slots_.size() << " weekly slots from " << path_ << slog::endl;
+    if (skipped) {
+        slog::warn << "Skipped " << skipped << " malformed lines of " << path_ << slog::endl;
+    }
+    return true;
+}
+
+void Timetable::ReloadIfChanged(std::chrono::system_clock::time_point time) {
+    if (checked_ && time < next_check_) {
+        return;
+    }
+    checked_ = true;
+    next_check_ = time + check_interval_;
+
+    FileStatus status;
+    if (!ReadFileStatus(path_, &status)) {
+        // the last timetable that was read stays in use
+        if (!missing_) {
+            slog::warn << "timetable file " << path_ << " does not exist" << slog::endl;
+        }
+        missing_ = true;
+        return;
+    }
+    missing_ = false;
+    if (status == file_status_) {
+        return;
+    }
+    file_status_ = status;
+    if (Load()) {
+        cached_ = false;
+    }
+}
+
+bool Timetable::Lookup(std::chrono::system_clock::time_point time, TimetableSlot* slot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ReloadIfChanged(time);
+
+    if (!cached_ || time < cached_from_ || time >= cached_until_) {
+        std::time_t t = std::chrono::system_clock::to_time_t(time);
+        std::tm local;
+        localtime_r(&t, &local);
+        const int minute = ((local.tm_wday + 6) % 7) * minutes_per_day + local.tm_hour * 60 + local.tm_min;
+
+        // the candidate is the last slot that starts at or before the current minute
+        auto next = std::upper_bound(slots_.begin(), slots_.end(), minute,
+                                     [](int value, const TimetableSlot& s) { return value < s.start; });
+        int boundary;
+        cached_slot_ = -1;
+        if (next != slots_.begin() && std::prev(next)->end > minute) {
+            cached_slot_ = static_cast<int>(std::prev(next) - slots_.begin());
+            boundary = std::prev(next)->end;
+        } else if (next != slots_.end()) {
+            boundary = next->start;
+        } else {
+            boundary = minutes_per_week + (slots_.empty() ? 0 : slots_.front().start);
+        }
+        cached_ = true;
+        cached_from_ = std::chrono::system_clock::from_time_t(t - local.tm_sec);
+        cached_until_ = cached_from_ + std::chrono::minutes(boundary - minute);
+    }
+
+    if (cached_slot_ < 0) {
+        return false;
+    }
+    *slot = slots_[cached_slot_];
+    return true;
+}
@@ -0,0 +1,134 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "track_identity.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace {
+
+// Boxes overlapping less than this belong to different faces
+const float min_track_iou = 0.5f;
+
+// Faces at least this many pixels wide and high give full quality embeddings
+const float full_quality_size = 64.0f;
+
+float IoU(const cv::Rect& a, const cv::Rect& b) {
+    const int united = (a | b).area();
+    return united > 0 ? static_cast<float>((a & b).area()) / united : 0.0f;
+}
+
+}  // anonymous namespace
+
+float FaceQuality(const cv::Rect& rect, float confidence) {
+    float size = std::min(1.0f, std::min(rect.width, rect.height) / full_quality_size);
+    return std::max(0.0f, std::min(1.0f, confidence)) * size;
+}
+
+TrackIdentityCache::TrackIdentityCache(const TrackIdentityParams& params) : params_(params) {}
+
+const TrackIdentityCache::TrackIdentity* TrackIdentityCache::FindTrack(const cv::Rect& face) const {
+    const TrackIdentity* best = nullptr;
+    float best_iou = min_track_iou;
+    for (const auto& item : tracks_) {
+        float iou = IoU(face, item.second.rect);
+        if (iou > best_iou) {
+            best_iou = iou;
+            best = &item.second;
+        }
+    }
+    return best;
+}
+
+int TrackIdentityCache::TrustedLabel(const cv::Rect& face, size_t frame_idx) const {
+    if (params_.verify_every == 0) {
+        return TrackedObject::UNKNOWN_LABEL_IDX;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    const TrackIdentity* best = FindTrack(face);
+    if (!best || best->verified_label == TrackedObject::UNKNOWN_LABEL_IDX ||
+        best->track_label != best->verified_label || best->confirmations < params_.min_confirmations ||
+        frame_idx >= best->verified_frame + params_.verify_every ||
+        IoU(face, best->verified_rect) < params_.min_box_iou) {
+        return TrackedObject::UNKNOWN_LABEL_IDX;
+    }
+    return best->verified_label;
+}
+
+cv::Mat TrackIdentityCache::Aggregate(const cv::Rect& face, const cv::Mat& embedding, float quality) const {
+    if (params_.max_track_weight <= 0) {
+        return cv::Mat();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    const TrackIdentity* track = FindTrack(face);
+    if (!track || track->weight <= 0 || track->mean_embedding.size() != embedding.size()) {
+        return cv::Mat();
+    }
+    cv::Mat combined;
+    cv::normalize(embedding, combined);
+    const float total = track->weight + quality;
+    cv::addWeighted(track->mean_embedding, track->weight / total, combined, quality / total, 0.0, combined);
+    cv::normalize(combined, combined);
+    return combined;
+}
+
+void TrackIdentityCache::Update(const TrackedObjects& tracked_faces, const std::vector<VerifiedFace>& verified,
+                                size_t frame_idx) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // tracks that are no longer followed are dropped
+    std::unordered_map<int, TrackIdentity> tracks;
+    for (const auto& face : tracked_faces) {
+        TrackIdentity identity = {face.rect, face.label, TrackedObject::UNKNOWN_LABEL_IDX, cv::Rect(), 0, 0,
+                                  cv::Mat(), TrackedObject::UNKNOWN_LABEL_IDX, 0.0f};
+        auto known = tracks_.find(face.object_id);
+        if (known != tracks_.end()) {
+            identity = known->second;
+            identity.rect = face.rect;
+            identity.track_label = face.label;
+        }
+
+        const VerifiedFace* check = nullptr;
+        float best_iou = min_track_iou;
+        for (const auto& object : verified) {
+            float iou = IoU(face.rect, object.rect);
+            if (iou > best_iou) {
+                best_iou = iou;
+                check = &object;
+            }
+        }
+        if (check) {
+            identity.confirmations = check->label == identity.verified_label ? identity.confirmations + 1 : 1;
+            identity.verified_label = check->label;
+            identity.verified_rect = check->rect;
+            identity.verified_frame = frame_idx;
+
+            // the label comes from the face alone, faces reid could not identify do not count
+            // and a new label starts the mean over
+            if (params_.max_track_weight > 0 && check->label != TrackedObject::UNKNOWN_LABEL_IDX &&
+                !check->embedding.empty()) {
+                cv::Mat embedding;
+                cv::normalize(check->embedding, embedding);
+                if (check->label != identity.mean_label || identity.weight <= 0 ||
+                    identity.mean_embedding.size() != embedding.size()) {
+                    embedding.copyTo(identity.mean_embedding);
+                    identity.mean_label = check->label;
+                    identity.weight = check->quality;
+                } else {
+                    const float total = identity.weight + check->quality;
+                    cv::addWeighted(identity.mean_embedding, identity.weight / total, embedding,
+                                    check->quality / total, 0.0, identity.mean_embedding);
+                    cv::normalize(identity.mean_embedding, identity.mean_embedding);
+                    identity.weight = std::min(total, params_.max_track_weight);
+                }
+            }
+        }
+        tracks.emplace(face.object_id, identity);
+    }
+    tracks_ = std::move(tracks);
+}
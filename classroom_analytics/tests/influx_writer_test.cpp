@@ -0,0 +1,398 @@
+// Copyright (C) 2019 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+//
+
+// Runs HttpConnection and InfluxWriter against a stub HTTP server on the
+// loopback interface. Every test scripts the answers of the server and checks
+// what reached it and over how many connections.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "influx_writer.hpp"
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                            \
+    do {                                                                            \
+        if (!(condition)) {                                                         \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": " #condition << std::endl; \
+            failures++;                                                             \
+        }                                                                           \
+    } while (false)
+
+/**
+* @brief Request received by the stub server
+*/
+struct StubRequest {
+    /** @brief Index of the connection it came over, in accept order */
+    int connection;
+    /** @brief Request line, e.g. "POST /write?db=Analytics HTTP/1.1" */
+    std::string line;
+    /** @brief Request body */
+    std::string body;
+};
+
+/**
+* @brief Answer of the stub server to a request
+*/
+struct StubResponse {
+    /** @brief Raw bytes sent back, status line, headers and body */
+    std::string data;
+    /** @brief Close the connection once the answer is sent */
+    bool close;
+};
+
+/**
+* @brief HTTP/1.1 server on 127.0.0.1 that answers every request through a handler
+*
+* Requests need a Content-Length, which is all HttpConnection sends. Every
+* connection is served by its own thread, the sockets are closed by the destructor.
+*/
+class StubServer {
+public:
+    explicit StubServer(std::function<StubResponse(const StubRequest&)> handler)
+        : handler_(handler), connections_(0), stopped_(false) {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        ::listen(listen_fd_, 16);
+        socklen_t size = sizeof(address);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &size);
+        port_ = ntohs(address.sin_port);
+        acceptor_ = std::thread(&StubServer::AcceptLoop, this);
+    }
+
+    ~StubServer() {
+        stopped_ = true;
+        ::shutdown(listen_fd_, SHUT_RDWR);
+        ::close(listen_fd_);
+        acceptor_.join();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (int fd : client_fds_) {
+                ::shutdown(fd, SHUT_RDWR);
+            }
+        }
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        for (int fd : client_fds_) {
+            ::close(fd);
+        }
+    }
+
+    int port() const { return port_; }
+
+    int Connections() const { return connections_.load(); }
+
+    std::vector<StubRequest> Requests() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return requests_;
+    }
+
+private:
+    void AcceptLoop() {
+        while (!stopped_) {
+            int fd = ::accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            client_fds_.push_back(fd);
+            workers_.emplace_back(&StubServer::Serve, this, fd, connections_++);
+        }
+    }
+
+    void Serve(int fd, int connection) {
+        std::string buffer;
+        char chunk[4096];
+        while (true) {
+            size_t header_end;
+            while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+                ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) {
+                    return;
+                }
+                buffer.append(chunk, static_cast<size_t>(n));
+            }
+            StubRequest request;
+            request.connection = connection;
+            request.line = buffer.substr(0, buffer.find("\r\n"));
+            size_t length = 0;
+            size_t field = buffer.find("Content-Length: ");
+            if (field != std::string::npos && field < header_end) {
+                length = std::strtoul(buffer.c_str() + field + 16, nullptr, 10);
+            }
+            while (buffer.size() < header_end + 4 + length) {
+                ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) {
+                    return;
+                }
+                buffer.append(chunk, static_cast<size_t>(n));
+            }
+            request.body = buffer.substr(header_end + 4, length);
+            buffer.erase(0, header_end + 4 + length);
+
+            StubResponse response = handler_(request);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                requests_.push_back(request);
+            }
+            ::send(fd, response.data.data(), response.data.size(), MSG_NOSIGNAL);
+            if (response.close) {
+                ::shutdown(fd, SHUT_RDWR);
+                return;
+            }
+        }
+    }
+
+    std::function<StubResponse(const StubRequest&)> handler_;
+    int listen_fd_;
+    int port_;
+    std::atomic<int> connections_;
+    std::atomic<bool> stopped_;
+    std::thread acceptor_;
+    std::vector<std::thread> workers_;
+    std::vector<int> client_fds_;
+    std::vector<StubRequest> requests_;
+    mutable std::mutex mutex_;
+};
+
+StubResponse NoContent(bool close = false) {
+    return {std::string("HTTP/1.1 204 No Content\r\n") + (close ? "Connection: close\r\n" : "") + "\r\n", close};
+}
+
+// Waits up to two seconds for the condition
+bool WaitFor(std::function<bool()> condition) {
+    for (int i = 0; i < 200 && !condition(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+void TestKeepAlive() {
+    StubServer server([](const StubRequest&) { return NoContent(); });
+    HttpConnection connection("127.0.0.1", server.port(), std::chrono::milliseconds(1000));
+    CHECK(connection.Post("/write", "text/plain", "a value=1") == 204);
+    CHECK(connection.Post("/write", "text/plain", "a value=2") == 204);
+    CHECK(server.Connections() == 1);
+    std::vector<StubRequest> requests = server.Requests();
+    CHECK(requests.size() == 2 && requests[1].body == "a value=2");
+}
+
+void TestConnectionClose() {
+    StubServer server([](const StubRequest&) { return NoContent(true); });
+    HttpConnection connection("127.0.0.1", server.port(), std::chrono::milliseconds(1000));
+    CHECK(connection.Post("/write", "text/plain", "a value=1") == 204);
+    CHECK(connection.Post("/write", "text/plain", "a value=2") == 204);
+    CHECK(server.Connections() == 2);
+}
+
+void TestServerDropsIdleConnection() {
+    // the server closes without saying so, the kept-alive connection fails on the next request
+    std::atomic<int> answered(0);
+    StubServer server([&answered](const StubRequest&) {
+        answered++;
+        return StubResponse{"HTTP/1.1 204 No Content\r\n\r\n", answered == 1};
+    });
+    HttpConnection connection("127.0.0.1", server.port(), std::chrono::milliseconds(1000));
+    CHECK(connection.Post("/write", "text/plain", "a value=1") == 204);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(connection.Post("/write", "text/plain", "a value=2") == 204);
+    CHECK(server.Connections() == 2);
+}
+
+void TestResponseBodies() {
+    StubServer server([](const StubRequest& request) {
+        if (request.line.find("/chunked") != std::string::npos) {
+            return StubResponse{"HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                                "5\r\nhello\r\n6;ext=1\r\n world\r\n0\r\nTrailer: x\r\n\r\n", false};
+        }
+        if (request.line.find("/length") != std::string::npos) {
+            return StubResponse{"HTTP/1.1 400 Bad Request\r\nContent-Length: 15\r\n\r\nunable to parse", false};
+        }
+        return StubResponse{"HTTP/1.0 200 OK\r\n\r\nuntil the end", true};
+    });
+    HttpConnection connection("127.0.0.1", server.port(), std::chrono::milliseconds(1000));
+    std::string body;
+    CHECK(connection.Post("/chunked", "text/plain", "", &body) == 200);
+    CHECK(body == "hello world");
+    body.clear();
+    CHECK(connection.Post("/length", "text/plain", "", &body) == 400);
+    CHECK(body == "unable to parse");
+    body.clear();
+    CHECK(connection.Post("/eof", "text/plain", "", &body) == 200);
+    CHECK(body == "until the end");
+    CHECK(server.Connections() == 1);
+}
+
+void TestUnreachable() {
+    int port;
+    {
+        StubServer server([](const StubRequest&) { return NoContent(); });
+        port = server.port();
+    }
+    HttpConnection connection("127.0.0.1", port, std::chrono::milliseconds(200));
+    CHECK(connection.Post("/write", "text/plain", "a value=1") == -1);
+}
+
+std::string MakeSpoolDir() {
+    char path[] = "/tmp/influx_writer_test.XXXXXX";
+    return mkdtemp(path) ? path : "";
+}
+
+void RemoveDir(const std::string& path) {
+    if (DIR* dir = opendir(path.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..") {
+                std::remove((path + '/' + name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+    ::rmdir(path.c_str());
+}
+
+InfluxConfig TestConfig(int port) {
+    InfluxConfig config;
+    config.host = "127.0.0.1";
+    config.port = port;
+    config.batch_size = 4;
+    config.flush_interval = std::chrono::milliseconds(20);
+    config.timeout = std::chrono::milliseconds(500);
+    return config;
+}
+
+// Number of lines of the write requests
+size_t WrittenLines(const std::vector<StubRequest>& requests) {
+    size_t lines = 0;
+    for (const auto& request : requests) {
+        if (request.line.find("/write") != std::string::npos) {
+            lines += std::count(request.body.begin(), request.body.end(), '\n');
+        }
+    }
+    return lines;
+}
+
+void TestBatches() {
+    StubServer server([](const StubRequest& request) {
+        if (request.line.find("/query") != std::string::npos) {
+            return StubResponse{"HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\n{}", false};
+        }
+        return NoContent();
+    });
+    InfluxWriter writer(TestConfig(server.port()));
+    for (int i = 0; i < 10; i++) {
+        writer.Write(LinePoint("m").Field("value", i));
+    }
+    writer.Close();
+    CHECK(writer.Written() == 10 && writer.Dropped() == 0);
+    CHECK(WrittenLines(server.Requests()) == 10);
+    // the database is created over the same keep-alive connection
+    CHECK(server.Connections() == 1);
+}
+
+void TestSpoolAndReplay() {
+    std::atomic<bool> down(true);
+    std::mutex accepted_mutex;
+    std::vector<StubRequest> accepted;
+    StubServer server([&](const StubRequest& request) {
+        if (down) {
+            return StubResponse{"HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n", false};
+        }
+        if (request.line.find("/query") != std::string::npos) {
+            return StubResponse{"HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\n{}", false};
+        }
+        std::lock_guard<std::mutex> lock(accepted_mutex);
+        accepted.push_back(request);
+        return NoContent();
+    });
+    const std::string spool_dir = MakeSpoolDir();
+    InfluxConfig config = TestConfig(server.port());
+    config.spool_dir = spool_dir;
+    {
+        InfluxWriter writer(config);
+        for (int i = 0; i < 10; i++) {
+            writer.Write(LinePoint("m").Field("value", i));
+        }
+        CHECK(WaitFor([&writer] { return writer.Spooled() == 10; }));
+        CHECK(writer.Written() == 0);
+
+        down = false;
+        CHECK(WaitFor([&writer] { return writer.Written() == 10; }));
+        CHECK(writer.Dropped() == 0);
+        writer.Close();
+    }
+    CHECK(WrittenLines(accepted) == 10);
+    RemoveDir(spool_dir);
+}
+
+void TestMemoryQueueWhileDown() {
+    std::atomic<bool> down(true);
+    StubServer server([&down](const StubRequest& request) {
+        if (down) {
+            return StubResponse{"HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+                                true};
+        }
+        if (request.line.find("/query") != std::string::npos) {
+            return StubResponse{"HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\n{}", false};
+        }
+        return NoContent();
+    });
+    InfluxWriter writer(TestConfig(server.port()));
+    for (int i = 0; i < 6; i++) {
+        writer.Write(LinePoint("m").Field("value", i));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(writer.Written() == 0 && writer.Dropped() == 0);
+    down = false;
+    CHECK(WaitFor([&writer] { return writer.Written() == 6; }));
+    writer.Close();
+    // every failed answer closed the connection, so the writer reconnected
+    CHECK(server.Connections() > 1);
+}
+
+}  // anonymous namespace
+
+int main() {
+    TestKeepAlive();
+    TestConnectionClose();
+    TestServerDropsIdleConnection();
+    TestResponseBodies();
+    TestUnreachable();
+    TestBatches();
+    TestSpoolAndReplay();
+    TestMemoryQueueWhileDown();
+    if (failures) {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}